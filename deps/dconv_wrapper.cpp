@@ -46,5 +46,19 @@ namespace double_conversion {
         delete static_cast<StringToDoubleConverter *>(*s2d);
         *s2d = NULL;
     }
+
+    // the converters used by pycjson are immutable, so each is built once (thread-safe since C++11) and shared
+    int dconv_d2s_json(double value, char *buf, int buflen, int *strlength) {
+        static const DoubleToStringConverter converter(DoubleToStringConverter::NO_FLAGS, "Infinity", "NaN", 'e', -324, 308, 0, 0);
+        StringBuilder sb(buf, buflen);
+        int success = static_cast<int>(converter.ToShortest(value, &sb));
+        *strlength = success ? sb.position() : -1;
+        return success;
+    }
+
+    double dconv_s2d_json(const char *buffer, int length, int *processed_characters_count) {
+        static const StringToDoubleConverter converter(StringToDoubleConverter::NO_FLAGS, 0.0, Double::NaN(), "Infinity", "NaN");
+        return converter.StringToDouble(buffer, length, processed_characters_count);
+    }
     }
 } // namespace double_conversion
\ No newline at end of file
@@ -49,6 +49,11 @@ void dconv_s2d_init(void **s2d, int flags, double empty_string_value,
 double dconv_s2d(void *s2d, const char *buffer, int length, int *processed_characters_count);
 
 void dconv_s2d_free(void **s2d);
+
+// shared converters with the settings used for JSON, no init / free needed
+int dconv_d2s_json(double value, char *buf, int buflen, int *strlength);
+
+double dconv_s2d_json(const char *buffer, int length, int *processed_characters_count);
 #ifdef __cplusplus
 }
 #endif
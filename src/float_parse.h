@@ -0,0 +1,20 @@
+#ifndef FLOAT_PARSE_H
+#define FLOAT_PARSE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Parse a JSON number of the form -?int(.frac)?([eE][+-]?exp)? starting at input, without reading past input_end.
+ * On success the correctly rounded double is stored in result and the number of bytes consumed is returned.
+ * 0 is returned when the number should be handed to a complete converter instead: a syntax this function does not
+ * accept, more than 19 significant digits or a product too close to a rounding boundary to decide. */
+size_t float_parse(const unsigned char *input, const unsigned char *input_end, double *result);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //FLOAT_PARSE_H
@@ -7,6 +7,21 @@ PyObject *pycJSON_Encode(PyObject *self, PyObject *args, PyObject *kwargs);
 PyObject *pycJSON_Decode(PyObject *self, PyObject *args, PyObject *kwargs);
 PyObject *pycJSON_FileEncode(PyObject *self, PyObject *args, PyObject *kwargs);
 PyObject *pycJSON_DecodeFile(PyObject *self, PyObject *args, PyObject *kwargs);
+PyObject *pycJSON_DecodePath(PyObject *self, PyObject *args, PyObject *kwargs);
+PyObject *pycJSON_DecodeFd(PyObject *self, PyObject *args, PyObject *kwargs);
+PyObject *pycJSON_RawDecode(PyObject *self, PyObject *args, PyObject *kwargs);
+PyObject *pycJSON_DecodeLazy(PyObject *self, PyObject *args, PyObject *kwargs);
+PyObject *pycJSON_CompileQuery(PyObject *self, PyObject *args, PyObject *kwargs);
+PyObject *pycJSON_Validate(PyObject *self, PyObject *args, PyObject *kwargs);
+PyObject *pycJSON_DecodeLines(PyObject *self, PyObject *args, PyObject *kwargs);
+PyObject *pycJSON_DecodeLinesIter(PyObject *self, PyObject *args, PyObject *kwargs);
+PyObject *pycJSON_DecodeLinesParallel(PyObject *self, PyObject *args, PyObject *kwargs);
+extern PyTypeObject IncrementalDecoderType;
+extern PyTypeObject LinesIteratorType;
+extern PyTypeObject LazyDocumentType;
+extern PyTypeObject LazyNodeType;
+extern PyTypeObject LazyIteratorType;
+extern PyTypeObject QueryType;
 
 PyObject *JSONDecodeError = NULL;
 
@@ -17,6 +32,15 @@ static PyMethodDef pycJSON_Methods[] = {
         {"loads", (PyCFunction) pycJSON_Decode, METH_VARARGS | METH_KEYWORDS, "Converts JSON as string to dict object structure."},
         {"dump", (PyCFunction) pycJSON_FileEncode, METH_VARARGS | METH_KEYWORDS, "Converts arbitrary object recursively into JSON file. "},
         {"load", (PyCFunction) pycJSON_DecodeFile, METH_VARARGS | METH_KEYWORDS, "Converts JSON as file to dict object structure."},
+        {"load_path", (PyCFunction) pycJSON_DecodePath, METH_VARARGS | METH_KEYWORDS, "Converts JSON file at path to dict object structure, memory-mapping regular files."},
+        {"load_fd", (PyCFunction) pycJSON_DecodeFd, METH_VARARGS | METH_KEYWORDS, "Converts JSON read from file descriptor to dict object structure, memory-mapping regular files."},
+        {"raw_decode", (PyCFunction) pycJSON_RawDecode, METH_VARARGS | METH_KEYWORDS, "Converts the first JSON document in a string from idx on, returns it with the index after it."},
+        {"lazy_loads", (PyCFunction) pycJSON_DecodeLazy, METH_VARARGS | METH_KEYWORDS, "Scans JSON as string once, arrays and objects are returned as nodes whose values are created when they are accessed."},
+        {"compile_query", (PyCFunction) pycJSON_CompileQuery, METH_VARARGS | METH_KEYWORDS, "Compiles JSON Pointer and JSONPath paths into a query whose extract method returns the values they select."},
+        {"validate", (PyCFunction) pycJSON_Validate, METH_VARARGS | METH_KEYWORDS, "Checks JSON as string without the GIL and without creating objects, returns True or the JSONDecodeError that describes why it is invalid."},
+        {"loads_lines", (PyCFunction) pycJSON_DecodeLines, METH_VARARGS | METH_KEYWORDS, "Converts JSON Lines as string to a list of dict object structures."},
+        {"iter_lines", (PyCFunction) pycJSON_DecodeLinesIter, METH_VARARGS | METH_KEYWORDS, "Iterates over the dict object structures of JSON Lines read from a file."},
+        {"load_lines_parallel", (PyCFunction) pycJSON_DecodeLinesParallel, METH_VARARGS | METH_KEYWORDS, "Converts the JSON Lines file at path to a list of dict object structures, scanning it on several threads."},
         {NULL, NULL, 0, NULL} /* Sentinel */
 };
 
@@ -83,6 +107,30 @@ PyMODINIT_FUNC PyInit_cjson(void) {
         PyErr_Clear();
 #endif
 
+    if ((PyType_Ready(&IncrementalDecoderType) < 0) || (PyType_Ready(&LinesIteratorType) < 0) || (PyType_Ready(&LazyDocumentType) < 0) ||
+        (PyType_Ready(&LazyNodeType) < 0) || (PyType_Ready(&LazyIteratorType) < 0) || (PyType_Ready(&QueryType) < 0)) {
+        Py_DECREF(module);
+        return NULL;
+    }
+    Py_INCREF(&IncrementalDecoderType);
+    if (PyModule_AddObject(module, "IncrementalDecoder", (PyObject *) &IncrementalDecoderType) < 0) {
+        Py_DECREF(&IncrementalDecoderType);
+        Py_DECREF(module);
+        return NULL;
+    }
+    Py_INCREF(&LazyNodeType);
+    if (PyModule_AddObject(module, "Node", (PyObject *) &LazyNodeType) < 0) {
+        Py_DECREF(&LazyNodeType);
+        Py_DECREF(module);
+        return NULL;
+    }
+    Py_INCREF(&QueryType);
+    if (PyModule_AddObject(module, "Query", (PyObject *) &QueryType) < 0) {
+        Py_DECREF(&QueryType);
+        Py_DECREF(module);
+        return NULL;
+    }
+
     JSONDecodeError = PyErr_NewException("cjson.JSONDecodeError", PyExc_ValueError, NULL);
     Py_XINCREF(JSONDecodeError);
     if (PyModule_AddObject(module, "JSONDecodeError", JSONDecodeError) < 0) {
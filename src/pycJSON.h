@@ -112,7 +112,7 @@ extern "C" {
 #define cJSON_StringIsConst 512
 
 /* Limits how deeply nested arrays/objects can be before cJSON rejects to parse them.
- * This is to prevent stack overflows. */
+ * The decoder uses it as the default of max_depth, its stack of open containers lives on the heap. */
 #ifndef CJSON_NESTING_LIMIT
 #define CJSON_NESTING_LIMIT 1000
 #endif
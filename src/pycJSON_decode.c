@@ -1,15 +1,48 @@
 #include "dconv_wrapper.h"
+#include "float_parse.h"
 #include "pycJSON.h"
 #include <math.h>
 #include <stdbool.h>
-/* check if the given size is left to read in a given parse buffer (starting with 1) */
-#define can_read(buffer, size) ((buffer != NULL) && (((buffer)->offset + size) <= (buffer)->length))
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PYCJSON_USE_SSE2
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#include <errno.h>
+#include <limits.h>
+#ifdef __WINDOWS__
+#include <fcntl.h>
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+/* check if the given size is left to read in a given parse buffer (starting with 1)
+ * The parser is only entered through parse_document with a non-empty input, so the buffer is never checked for NULL. */
+#define can_read(buffer, size) (((buffer)->offset + (size)) <= (buffer)->length)
 /* check if the buffer can be accessed at the given index (starting with 0) */
-#define can_access_at_index(buffer, index) ((buffer != NULL) && (((buffer)->offset + index) < (buffer)->length))
+#define can_access_at_index(buffer, index) (((buffer)->offset + (index)) < (buffer)->length)
 #define cannot_access_at_index(buffer, index) (!can_access_at_index(buffer, index))
-/* get a pointer to the buffer at the position */
-#define buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
+/* the position of the current offset in the whole input, for error messages */
+#define error_position(buffer) ((buffer)->origin + (buffer)->offset)
 #define STACK_BUFFER_SIZE 512
+#define VALUE_STACK_SIZE 256
+#define READ_CHUNK_SIZE 65536
+#define READ_BUFFER_KEEP_SIZE (16 << 20) /* the largest read buffer that is kept for the next read_fd */
+#define KEY_CACHE_SIZE 256 /* must be a power of two */
+#define KEY_CACHE_MAX_KEY_LENGTH 64
+#define CONTAINER_STACK_SIZE 64
 
 typedef struct internal_hooks {
     void *(CJSON_CDECL *allocate)(size_t size);
@@ -17,444 +50,642 @@ typedef struct internal_hooks {
 } internal_hooks;
 
 static internal_hooks global_hooks = {PyMem_Malloc, PyMem_Free};
-static void *dconv_s2d_ptr = NULL;
+
+/* an object key seen earlier in the same call, looked up by its raw characters */
+typedef struct key_cache_entry {
+    const void *raw; /* points into the input, between the quotes */
+    Py_ssize_t raw_length;
+    PyObject *key;
+} key_cache_entry;
+
+/* what the parser expects next */
+typedef enum parse_state {
+    STATE_VALUE, /* a value */
+    STATE_ARRAY_START, /* the first value of an array or its end */
+    STATE_OBJECT_START, /* the first key of an object or its end */
+    STATE_KEY, /* a key after a comma */
+    STATE_COLON, /* the colon after a key */
+    STATE_NEXT /* a comma or the end of the innermost open container */
+} parse_state;
+
+/* what happens to a line of JSON Lines input that is not a valid document */
+typedef enum line_errors {
+    LINE_ERRORS_RAISE, /* the error is raised */
+    LINE_ERRORS_SKIP, /* the line is left out */
+    LINE_ERRORS_COLLECT /* the error takes the place of the document, with the line number in its lineno attribute */
+} line_errors;
+
+/* why a string is invalid */
+typedef enum string_error {
+    STRING_VALID,
+    STRING_UNTERMINATED, /* the input ends before the closing quote */
+    STRING_BACKSLASH_AT_END, /* the input ends after a backslash */
+    STRING_INVALID_UTF16, /* a \u escape is not a valid UTF-16 literal */
+    STRING_INVALID_ESCAPE, /* a backslash is followed by a character that cannot be escaped */
+    STRING_INVALID_UTF8 /* a raw character is not valid UTF-8 */
+} string_error;
+
+/* an array or object whose children are being parsed */
+typedef struct container_frame {
+    Py_ssize_t stack_base; /* where its children start on the value stack */
+    bool is_object; /* children are key and value pairs */
+    PyObject *projection; /* the include or exclude dict its members are selected by, NULL if they are all kept */
+} container_frame;
 
 typedef struct
 {
-    const unsigned char *content;
-    Py_ssize_t length;
+    const void *content; /* code units of the representation the parser was instantiated for */
+    Py_ssize_t length; /* in code units, as are offset and every position in an error message */
     Py_ssize_t offset;
-    Py_ssize_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset. */
+    Py_ssize_t origin; /* position of content in the whole input, content is a window of it in incremental parsing */
+    Py_ssize_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset, the number of open containers. */
     internal_hooks hooks;
+    unsigned char *string_buffer; /* scratch space for numbers that have to be terminated */
+    Py_ssize_t string_buffer_size;
+    key_cache_entry *key_cache; /* allocated by the first object */
+    PyObject **value_stack; /* children of the open containers, owned references */
+    Py_ssize_t value_stack_size;
+    Py_ssize_t value_stack_top;
+    container_frame *containers; /* the open arrays and objects, innermost last */
+    Py_ssize_t containers_size;
+    parse_state state;
+    bool partial; /* more input may follow content, a token that runs into its end is left for the next window */
+    Py_ssize_t scanned; /* how far the string at offset was searched for its end in an earlier window */
     /* kwargs */
     PyObject *object_hook;
+    Py_ssize_t max_depth;
+    Py_ssize_t max_digits; /* the limit of int on the digits of a string for skipped values, -1 until one is skipped */
+    PyObject *projection; /* include or exclude dict of the document, NULL for none */
+    bool exclude; /* the members projection names are skipped rather than kept */
+    PyObject *member_projection; /* the projection of the value of the member being parsed */
 } parse_buffer;
 
-static bool parse_value(PyObject **item, parse_buffer *const input_buffer);
+/* a parse_buffer with nothing to parse yet, the members not named are zero */
+#define PARSE_BUFFER_INIT                                                                           \
+    {.state = STATE_VALUE, .partial = false, .object_hook = NULL, .max_depth = CJSON_NESTING_LIMIT, \
+     .max_digits = -1, .projection = NULL, .exclude = false, .member_projection = NULL}
 
-/* parse 4 digit hexadecimal number */
-static unsigned parse_hex4(const unsigned char *const input) {
-    unsigned int h = 0;
-    Py_ssize_t i = 0;
-    for (i = 0; i < 4; i++) {
-        /* parse digit */
-        if ((input[i] >= '0') && (input[i] <= '9')) {
-            h += (unsigned int) input[i] - '0';
-        } else if ((input[i] >= 'A') && (input[i] <= 'F')) {
-            h += (unsigned int) 10 + input[i] - 'A';
-        } else if ((input[i] >= 'a') && (input[i] <= 'f')) {
-            h += (unsigned int) 10 + input[i] - 'a';
-        } else /* invalid */
-        {
-            return 0;
-        }
 
-        if (i < 3) {
-            /* shift left to make place for the next nibble */
-            h = h << 4;
-        }
-    }
+/* index of the lowest set bit, bits must not be 0 */
+static inline int count_trailing_zeros(unsigned int bits) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return (int) index;
+#else
+    return __builtin_ctz(bits);
+#endif
+}
 
-    return h;
+/* number of set bits */
+static inline int count_set_bits(unsigned int bits) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    bits = bits - ((bits >> 1) & 0x55555555);
+    bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333);
+    return (int) ((((bits + (bits >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24);
+#else
+    return __builtin_popcount(bits);
+#endif
 }
 
-/* converts a UTF-16 literal to UTF-8
- * A literal can be one or two sequences of the form \uXXXX */
-static unsigned char utf16_literal_to_utf8(const unsigned char *const input_pointer, const unsigned char *const input_end, unsigned char **output_pointer) {
-    assert(output_pointer);
-    long unsigned int codepoint = 0;
-    unsigned int first_code = 0;
-    const unsigned char *first_sequence = input_pointer;
-    unsigned char utf8_length = 0;
-    unsigned char utf8_position = 0;
-    unsigned char sequence_length = 0;
-    unsigned char first_byte_mark = 0;
+#ifdef PYCJSON_USE_SSE2
+/* one bit for each of the 16 bytes that is not whitespace (<= 32) */
+static inline unsigned int non_whitespace_mask(const unsigned char *const input) {
+    const __m128i chunk = _mm_loadu_si128((const __m128i *) input);
+    const __m128i whitespace = _mm_cmpeq_epi8(_mm_min_epu8(chunk, _mm_set1_epi8(' ')), chunk);
+    return (unsigned int) _mm_movemask_epi8(whitespace) ^ 0xFFFF;
+}
+#endif
 
-    if ((input_end - first_sequence) < 6) {
-        /* input ends unexpectedly */
-        goto fail;
+/* length of the run before the first quote, backslash or non-ASCII byte */
+static inline Py_ssize_t scan_string_ascii(const unsigned char *const input, const unsigned char *const input_end) {
+    const unsigned char *pointer = input;
+#ifdef PYCJSON_USE_SSE2
+    while (input_end - pointer >= 16) {
+        const __m128i chunk = _mm_loadu_si128((const __m128i *) pointer);
+        /* the high bit of a non-ASCII byte is already set */
+        const __m128i special = _mm_or_si128(chunk, _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\"')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))));
+        const unsigned int mask = (unsigned int) _mm_movemask_epi8(special);
+        if (mask != 0) {
+            return (Py_ssize_t) (pointer - input) + count_trailing_zeros(mask);
+        }
+        pointer += 16;
     }
+#endif
+    while ((pointer < input_end) && (*pointer != '\"') && (*pointer != '\\') && (*pointer < 0x80)) {
+        pointer++;
+    }
+    return (Py_ssize_t) (pointer - input);
+}
 
-    /* get the first utf16 sequence */
-    first_code = parse_hex4(first_sequence + 2);
-
-    /* check that the code is valid */
-    if (((first_code >= 0xDC00) && (first_code <= 0xDFFF))) {
-        goto fail;
+/* length of the run before the first quote or backslash */
+static inline Py_ssize_t scan_string_unicode(const unsigned char *const input, const unsigned char *const input_end) {
+    const unsigned char *pointer = input;
+#ifdef PYCJSON_USE_SSE2
+    while (input_end - pointer >= 16) {
+        const __m128i chunk = _mm_loadu_si128((const __m128i *) pointer);
+        const __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\"')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\')));
+        const unsigned int mask = (unsigned int) _mm_movemask_epi8(special);
+        if (mask != 0) {
+            return (Py_ssize_t) (pointer - input) + count_trailing_zeros(mask);
+        }
+        pointer += 16;
     }
+#endif
+    while ((pointer < input_end) && (*pointer != '\"') && (*pointer != '\\')) {
+        pointer++;
+    }
+    return (Py_ssize_t) (pointer - input);
+}
 
-    /* UTF16 surrogate pair */
-    if ((first_code >= 0xD800) && (first_code <= 0xDBFF)) {
-        const unsigned char *second_sequence = first_sequence + 6;
-        unsigned int second_code = 0;
-        sequence_length = 12; /* \uXXXX\uXXXX */
+#ifdef PYCJSON_USE_SSE2
+/* all bits set in the bytes of a that are at least b, unsigned */
+#define bytes_at_least(a, b) _mm_cmpeq_epi8(_mm_max_epu8((a), _mm_set1_epi8((char) (b))), (a))
 
-        if ((input_end - second_sequence) < 6) {
-            /* input ends unexpectedly */
-            goto fail;
+/* Validate the raw characters at input 16 bytes at a time, up to the first quote or backslash.
+ * Every byte is checked against the lead bytes one to three positions before it, the lookup-free form of the
+ * Keiser-Lemire validator (their nibble lookup tables need SSSE3). A block never ends inside a sequence, so no state
+ * is carried between blocks. Returns the number of bytes that were validated, adds the number of characters they
+ * encode to length and raises maxchar to the smallest code point of the widest PyUnicode kind they need.
+ * An invalid block, and the last 15 bytes of the input, are left to the caller to go through one character at a time. */
+static Py_ssize_t validate_utf8_run(const unsigned char *const input, const unsigned char *const input_end, Py_ssize_t *length, Py_UCS4 *maxchar) {
+    const unsigned char *pointer = input;
+
+    while (input_end - pointer >= 16) {
+        const __m128i chunk = _mm_loadu_si128((const __m128i *) pointer);
+        const unsigned int special = (unsigned int) _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\"')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))));
+        const int stop = (special != 0) ? count_trailing_zeros(special) : 16;
+        unsigned int checked = 0;
+        unsigned int measured = 0;
+        int block_length = stop;
+
+        if (_mm_movemask_epi8(chunk) == 0) {
+            /* ASCII */
+            *length += stop;
+            pointer += stop;
+            if (stop < 16) {
+                break;
+            }
+            continue;
         }
 
-        if ((second_sequence[0] != '\\') || (second_sequence[1] != 'u')) {
-            /* missing second half of the surrogate pair */
-            goto fail;
+        {
+            const __m128i prev1 = _mm_slli_si128(chunk, 1);
+            const __m128i prev2 = _mm_slli_si128(chunk, 2);
+            const __m128i prev3 = _mm_slli_si128(chunk, 3);
+            /* 0x80 - 0xBF are the only bytes below 0xC0 as signed chars */
+            const __m128i continuation = _mm_cmplt_epi8(chunk, _mm_set1_epi8((char) 0xC0));
+            const __m128i required = _mm_or_si128(bytes_at_least(prev1, 0xC0), _mm_or_si128(bytes_at_least(prev2, 0xE0), bytes_at_least(prev3, 0xF0)));
+            const __m128i at_least_90 = bytes_at_least(chunk, 0x90);
+            const __m128i at_least_a0 = bytes_at_least(chunk, 0xA0);
+            __m128i error = _mm_xor_si128(continuation, required);
+            /* bytes that never occur: C0, C1 (overlong) and F5 - FF (above U+10FFFF) */
+            error = _mm_or_si128(error, _mm_cmpeq_epi8(_mm_and_si128(chunk, _mm_set1_epi8((char) 0xFE)), _mm_set1_epi8((char) 0xC0)));
+            error = _mm_or_si128(error, bytes_at_least(chunk, 0xF5));
+            /* second bytes that make a sequence overlong, a surrogate or too large */
+            error = _mm_or_si128(error, _mm_andnot_si128(at_least_a0, _mm_cmpeq_epi8(prev1, _mm_set1_epi8((char) 0xE0))));
+            error = _mm_or_si128(error, _mm_and_si128(at_least_a0, _mm_cmpeq_epi8(prev1, _mm_set1_epi8((char) 0xED))));
+            error = _mm_or_si128(error, _mm_andnot_si128(at_least_90, _mm_cmpeq_epi8(prev1, _mm_set1_epi8((char) 0xF0))));
+            error = _mm_or_si128(error, _mm_and_si128(at_least_90, _mm_cmpeq_epi8(prev1, _mm_set1_epi8((char) 0xF4))));
+
+            if (stop < 16) {
+                /* the quote or backslash must not be needed as a continuation byte either */
+                checked = (2u << stop) - 1;
+            } else {
+                /* a sequence that continues in the next block is left to that block, the bytes of it that are here
+                 * are still checked against the ones before them */
+                if (pointer[15] >= 0xC0) {
+                    block_length = 15;
+                } else if (pointer[14] >= 0xE0) {
+                    block_length = 14;
+                } else if (pointer[13] >= 0xF0) {
+                    block_length = 13;
+                }
+                checked = 0xFFFF;
+            }
+            if (((unsigned int) _mm_movemask_epi8(error) & checked) != 0) {
+                break;
+            }
+
+            measured = (1u << block_length) - 1;
+            *length += count_set_bits(~(unsigned int) _mm_movemask_epi8(continuation) & measured);
+            /* lead bytes from F0 encode U+10000 and above, from C4 U+0100 and above, from C2 U+0080 and above */
+            if ((*maxchar < 0x10000) && (((unsigned int) _mm_movemask_epi8(bytes_at_least(chunk, 0xF0)) & measured) != 0)) {
+                *maxchar = 0x10000;
+            } else if ((*maxchar < 0x100) && (((unsigned int) _mm_movemask_epi8(bytes_at_least(chunk, 0xC4)) & measured) != 0)) {
+                *maxchar = 0x100;
+            } else if ((*maxchar < 0x80) && (((unsigned int) _mm_movemask_epi8(chunk) & measured) != 0)) {
+                *maxchar = 0x80;
+            }
         }
 
-        /* get the second utf16 sequence */
-        second_code = parse_hex4(second_sequence + 2);
-        /* check that the code is valid */
-        if ((second_code < 0xDC00) || (second_code > 0xDFFF)) {
-            /* invalid second half of the surrogate pair */
-            goto fail;
+        pointer += block_length;
+        if (stop < 16) {
+            break;
         }
+    }
 
+    return (Py_ssize_t) (pointer - input);
+}
+#endif
 
-        /* calculate the unicode codepoint from the surrogate pair */
-        codepoint = 0x10000 + (((first_code & 0x3FF) << 10) | (second_code & 0x3FF));
-    } else {
-        sequence_length = 6; /* \uXXXX */
-        codepoint = first_code;
-    }
+/* decode the UTF-8 sequence at input, which starts with a byte of 0x80 or above, into codepoint.
+ * Returns the length of the sequence, or 0 if it is truncated, overlong, encodes a surrogate or is above U+10FFFF */
+static inline unsigned char decode_utf8(const unsigned char *const input, const unsigned char *const input_end, Py_UCS4 *codepoint) {
+    const unsigned char first = input[0];
+    const Py_ssize_t available = input_end - input;
 
-    /* encode as UTF-8
-     * takes at maximum 4 bytes to encode:
-     * 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
-    if (codepoint < 0x80) {
-        /* normal ascii, encoding 0xxxxxxx */
-        utf8_length = 1;
-    } else if (codepoint < 0x800) {
+    if ((first >= 0xC2) && (first <= 0xDF)) {
         /* two bytes, encoding 110xxxxx 10xxxxxx */
-        utf8_length = 2;
-        first_byte_mark = 0xC0; /* 11000000 */
-    } else if (codepoint < 0x10000) {
-        /* three bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx */
-        utf8_length = 3;
-        first_byte_mark = 0xE0; /* 11100000 */
-    } else if (codepoint <= 0x10FFFF) {
-        /* four bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx 10xxxxxx */
-        utf8_length = 4;
-        first_byte_mark = 0xF0; /* 11110000 */
-    } else {
-        /* invalid unicode codepoint */
-        goto fail;
+        if ((available < 2) || ((input[1] & 0xC0) != 0x80)) {
+            return 0;
+        }
+        *codepoint = ((Py_UCS4) (first & 0x1F) << 6) | (input[1] & 0x3F);
+        return 2;
     }
-
-    /* encode as utf8 */
-    for (utf8_position = (unsigned char) (utf8_length - 1); utf8_position > 0; utf8_position--) {
-        /* 10xxxxxx */
-        (*output_pointer)[utf8_position] = (unsigned char) ((codepoint | 0x80) & 0xBF);
-        codepoint >>= 6;
+    if ((first >= 0xE0) && (first <= 0xEF)) {
+        /* three bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx */
+        if ((available < 3) || ((input[1] & 0xC0) != 0x80) || ((input[2] & 0xC0) != 0x80)) {
+            return 0;
+        }
+        *codepoint = ((Py_UCS4) (first & 0x0F) << 12) | ((Py_UCS4) (input[1] & 0x3F) << 6) | (input[2] & 0x3F);
+        if ((*codepoint < 0x800) || ((*codepoint >= 0xD800) && (*codepoint <= 0xDFFF))) {
+            return 0;
+        }
+        return 3;
     }
-    /* encode first byte */
-    if (utf8_length > 1) {
-        (*output_pointer)[0] = (unsigned char) ((codepoint | first_byte_mark) & 0xFF);
-    } else {
-        (*output_pointer)[0] = (unsigned char) (codepoint & 0x7F);
+    if ((first >= 0xF0) && (first <= 0xF4)) {
+        /* four bytes, encoding 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
+        if ((available < 4) || ((input[1] & 0xC0) != 0x80) || ((input[2] & 0xC0) != 0x80) || ((input[3] & 0xC0) != 0x80)) {
+            return 0;
+        }
+        *codepoint = ((Py_UCS4) (first & 0x07) << 18) | ((Py_UCS4) (input[1] & 0x3F) << 12) | ((Py_UCS4) (input[2] & 0x3F) << 6) | (input[3] & 0x3F);
+        if ((*codepoint < 0x10000) || (*codepoint > 0x10FFFF)) {
+            return 0;
+        }
+        return 4;
     }
 
-    *output_pointer += utf8_length;
-
-    return sequence_length;
-
-fail:
     return 0;
 }
 
-/* Utility to jump whitespace and cr/lf */
-static parse_buffer *buffer_skip_whitespace(parse_buffer *const buffer) {
-    if ((buffer == NULL) || (buffer->content == NULL)) {
-        return NULL;
-    }
+/* decode a UTF-8 sequence that is known to be valid, returns its length */
+static inline unsigned char decode_utf8_unchecked(const unsigned char *const input, Py_UCS4 *codepoint) {
+    const unsigned char first = input[0];
 
-    if (cannot_access_at_index(buffer, 0)) {
-        return buffer;
+    if (first < 0xE0) {
+        *codepoint = ((Py_UCS4) (first & 0x1F) << 6) | (input[1] & 0x3F);
+        return 2;
     }
+    if (first < 0xF0) {
+        *codepoint = ((Py_UCS4) (first & 0x0F) << 12) | ((Py_UCS4) (input[1] & 0x3F) << 6) | (input[2] & 0x3F);
+        return 3;
+    }
+    *codepoint = ((Py_UCS4) (first & 0x07) << 18) | ((Py_UCS4) (input[1] & 0x3F) << 12) | ((Py_UCS4) (input[2] & 0x3F) << 6) | (input[3] & 0x3F);
+    return 4;
+}
 
-    while (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] <= 32)) {
-        buffer->offset++;
+/* make sure the string buffer can hold at least size bytes, keeping its content */
+static bool ensure_string_buffer(parse_buffer *const input_buffer, Py_ssize_t size) {
+    unsigned char *new_buffer = NULL;
+    Py_ssize_t new_size = input_buffer->string_buffer_size;
+
+    if (size <= input_buffer->string_buffer_size) {
+        return true;
+    }
+    if (new_size < STACK_BUFFER_SIZE) {
+        new_size = STACK_BUFFER_SIZE;
+    }
+    while (new_size < size) {
+        new_size *= 2;
     }
 
-    if (buffer->offset == buffer->length) {
-        buffer->offset--;
+    new_buffer = (unsigned char *) input_buffer->hooks.allocate((size_t) new_size);
+    if (new_buffer == NULL) {
+        PyErr_Format(PyExc_MemoryError, "Failed to parse number: allocation failure\nposition: %zd", error_position(input_buffer));
+        return false;
+    }
+    if (input_buffer->string_buffer != NULL) {
+        memcpy(new_buffer, input_buffer->string_buffer, (size_t) input_buffer->string_buffer_size);
+        input_buffer->hooks.deallocate(input_buffer->string_buffer);
     }
+    input_buffer->string_buffer = new_buffer;
+    input_buffer->string_buffer_size = new_size;
 
-    return buffer;
+    return true;
 }
 
-/* skip the UTF-8 BOM (byte order mark) if it is at the beginning of a buffer */
-static parse_buffer *skip_utf8_bom(parse_buffer *const buffer) {
-    if ((buffer == NULL) || (buffer->content == NULL) || (buffer->offset != 0)) {
-        return NULL;
-    }
+/* push an owned reference onto the value stack, the reference is released if that fails */
+static bool push_value(parse_buffer *const input_buffer, PyObject *value) {
+    PyObject **new_stack = NULL;
+    Py_ssize_t new_size = input_buffer->value_stack_size;
 
-    if (can_access_at_index(buffer, 4) && (strncmp((const char *) buffer_at_offset(buffer), "\xEF\xBB\xBF", 3) == 0)) {
-        buffer->offset += 3;
+    if (input_buffer->value_stack_top == input_buffer->value_stack_size) {
+        new_size = (new_size == 0) ? VALUE_STACK_SIZE : new_size * 2;
+        new_stack = (PyObject **) input_buffer->hooks.allocate((size_t) new_size * sizeof(PyObject *));
+        if (new_stack == NULL) {
+            Py_DECREF(value);
+            PyErr_Format(PyExc_MemoryError, "Failed to parse JSON: allocation failure\nposition: %zd", error_position(input_buffer));
+            return false;
+        }
+        if (input_buffer->value_stack != NULL) {
+            memcpy(new_stack, input_buffer->value_stack, (size_t) input_buffer->value_stack_top * sizeof(PyObject *));
+            input_buffer->hooks.deallocate(input_buffer->value_stack);
+        }
+        input_buffer->value_stack = new_stack;
+        input_buffer->value_stack_size = new_size;
     }
+    input_buffer->value_stack[input_buffer->value_stack_top++] = value;
 
-    return buffer;
+    return true;
 }
 
-// define two helper macros for the string parsing
-#define PARSE_STRING_CHAR_MATCHER(x) \
-    case 'b':                        \
-        *buffer_writer++ = '\b';     \
-        break;                       \
-    case 'f':                        \
-        *buffer_writer++ = '\f';     \
-        break;                       \
-    case 'n':                        \
-        *buffer_writer++ = '\n';     \
-        break;                       \
-    case 'r':                        \
-        *buffer_writer++ = '\r';     \
-        break;                       \
-    case 't':                        \
-        *buffer_writer++ = '\t';     \
-        break;                       \
-    case '\"':                       \
-    case '\\':                       \
-    case '/':                        \
-        *buffer_writer++ = (x);      \
-        break;
-
-#define PARSE_STRING_FINALIZE                                            \
-    if (buffer_ptr != NULL && buffer_ptr != parse_string_stack_buffer) { \
-        input_buffer->hooks.deallocate(buffer_ptr);                      \
+/* drop the values pushed since base */
+static void pop_values(parse_buffer *const input_buffer, Py_ssize_t base) {
+    while (input_buffer->value_stack_top > base) {
+        Py_DECREF(input_buffer->value_stack[--input_buffer->value_stack_top]);
     }
+}
 
-/* Parse the input text into an unescaped cinput, and populate item. */
-static bool parse_string(PyObject **item, parse_buffer *const input_buffer) {
-    assert(item);
-    const unsigned char *input_pointer = buffer_at_offset(input_buffer) + 1;
-    const unsigned char *input_end = buffer_at_offset(input_buffer) + 1;
+/* open an array or object at the current offset */
+static bool open_container(parse_buffer *const input_buffer, bool is_object) {
+    if (input_buffer->depth >= input_buffer->max_depth) {
+        if (is_object) {
+            PyErr_Format(PyExc_ValueError, "Failed to parse dictionary: too deeply nested\nposition: %zd", error_position(input_buffer));
+        } else {
+            PyErr_Format(PyExc_ValueError, "Failed to parse array: too deeply nested\nposition: %zd", error_position(input_buffer));
+        }
+        return false; /* to deeply nested */
+    }
+    if (input_buffer->depth == input_buffer->containers_size) {
+        const Py_ssize_t new_size = (input_buffer->containers_size == 0) ? CONTAINER_STACK_SIZE : input_buffer->containers_size * 2;
+        container_frame *new_containers = (container_frame *) input_buffer->hooks.allocate((size_t) new_size * sizeof(container_frame));
+        if (new_containers == NULL) {
+            PyErr_Format(PyExc_MemoryError, "Failed to parse JSON: allocation failure\nposition: %zd", error_position(input_buffer));
+            return false;
+        }
+        if (input_buffer->containers != NULL) {
+            memcpy(new_containers, input_buffer->containers, (size_t) input_buffer->depth * sizeof(container_frame));
+            input_buffer->hooks.deallocate(input_buffer->containers);
+        }
+        input_buffer->containers = new_containers;
+        input_buffer->containers_size = new_size;
+    }
+    input_buffer->containers[input_buffer->depth].stack_base = input_buffer->value_stack_top;
+    input_buffer->containers[input_buffer->depth].is_object = is_object;
+    input_buffer->containers[input_buffer->depth].projection = NULL;
+    if (input_buffer->projection != NULL) {
+        /* the elements of arrays are projected like the array itself */
+        if (input_buffer->depth == 0) {
+            input_buffer->containers[0].projection = input_buffer->projection;
+        } else if (input_buffer->containers[input_buffer->depth - 1].is_object) {
+            input_buffer->containers[input_buffer->depth].projection = input_buffer->member_projection;
+        } else {
+            input_buffer->containers[input_buffer->depth].projection = input_buffer->containers[input_buffer->depth - 1].projection;
+        }
+    }
+    input_buffer->depth++;
 
-    unsigned char *buffer_writer = NULL;
-    unsigned char *buffer_ptr = NULL;
-    unsigned char parse_string_stack_buffer[STACK_BUFFER_SIZE];
+    return true;
+}
 
+/* Decide if the member with key of the innermost object is kept, setting member_projection to the projection of its
+ * value. Returns 1 if it is kept, 0 if it is skipped and -1 with an error set. */
+static int project_member(parse_buffer *const input_buffer, PyObject *key) {
+    PyObject *const projection = input_buffer->containers[input_buffer->depth - 1].projection;
+    PyObject *entry = NULL;
 
-    /* not a string */
-    if (buffer_at_offset(input_buffer)[0] != '\"') {
-        PyErr_Format(PyExc_ValueError, "Failed to parse string: it is not a string\nposition: %d", input_buffer->offset);
-        goto fail;
+    input_buffer->member_projection = NULL;
+    if (projection == NULL) {
+        return 1;
     }
+    entry = PyDict_GetItemWithError(projection, key);
+    if (entry == NULL) {
+        return PyErr_Occurred() ? -1 : input_buffer->exclude;
+    }
+    if (PyDict_Check(entry)) {
+        input_buffer->member_projection = entry;
+        return 1;
+    }
+    return (entry == Py_True) != input_buffer->exclude;
+}
 
-    {
-        bool is_ascii = true;
-        /* calculate approximate size of the output (overestimate) */
-        Py_ssize_t allocation_length = 0;
-        Py_ssize_t skipped_bytes = 0;
-        while (((Py_ssize_t) (input_end - input_buffer->content) < input_buffer->length) && (*input_end != '\"')) {
-            if (is_ascii && (*input_end & 0x80)) {
-                is_ascii = false;
-            }
-            /* is escape sequence */
-            if (input_end[0] == '\\') {
-                if ((Py_ssize_t) (input_end + 1 - input_buffer->content) >= input_buffer->length) {
-                    /* prevent buffer overflow when last input character is a backslash */
-                    PyErr_Format(PyExc_ValueError, "Failed to parse string: buffer overflow\nposition: %d", input_buffer->offset);
-                    goto fail;
-                }
-                if (is_ascii && input_end[1] == 'u') {
-                    is_ascii = false;
-                }
-                skipped_bytes++;
-                input_end++;
-            }
-            input_end++;
-        }
-        if (((Py_ssize_t) (input_end - input_buffer->content) >= input_buffer->length) || (*input_end != '\"')) {
-            PyErr_Format(PyExc_ValueError, "Failed to parse string: string ended unexpectedly\nposition: %d", input_buffer->offset);
-            goto fail; /* string ended unexpectedly */
-        }
-
-        /* This is at most how much we need for the output */
-        allocation_length = (Py_ssize_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
+/* close the innermost open container, moving its children from the value stack into a new list or dict */
+static PyObject *close_container(parse_buffer *const input_buffer) {
+    const container_frame *const frame = &input_buffer->containers[input_buffer->depth - 1];
+    const Py_ssize_t stack_base = frame->stack_base;
+    PyObject *item = NULL;
+    Py_ssize_t i;
 
-        // fast path for pure ASCII
-        if (is_ascii) {
-            *item = PyUnicode_New(allocation_length - 1, 127);
-            if (*item == NULL) {
-                PyErr_Format(PyExc_MemoryError, "Failed to parse string: allocation failure\nposition: %d", input_buffer->offset);
-                goto fail; /* allocation failure */
-            }
-            buffer_writer = (unsigned char *) PyUnicode_1BYTE_DATA(*item);
-            input_buffer->offset++;
-            while (input_buffer->offset < input_buffer->length && buffer_at_offset(input_buffer)[0] != '\"') {
-                if (buffer_at_offset(input_buffer)[0] != '\\') {
-                    *buffer_writer++ = buffer_at_offset(input_buffer)[0];
-                    input_buffer->offset++;
-                }
-                /* escape sequence */
-                else {
-                    unsigned char this_char = buffer_at_offset(input_buffer)[1];
-                    switch (this_char) {
-                        PARSE_STRING_CHAR_MATCHER(this_char);
-                        default:
-                            PyErr_Format(PyExc_ValueError, "Failed to parse string: invalid escape sequence(%d)\nposition: %d", this_char, input_buffer->offset);
-                            goto fail;
-                    }
-                    input_buffer->offset += 2;
-                }
-            }
-            goto success;
+    if (!frame->is_object) {
+        /* the length is known now, move the values into an exactly sized list */
+        item = PyList_New(input_buffer->value_stack_top - stack_base);
+        if (item == NULL) {
+            return NULL;
         }
-
-        if (allocation_length < STACK_BUFFER_SIZE) {
-            buffer_ptr = parse_string_stack_buffer;
-        } else {
-            unsigned char *malloc_ptr;
-            malloc_ptr = (unsigned char *) input_buffer->hooks.allocate(allocation_length + sizeof(""));
-            if (malloc_ptr == NULL) {
-                PyErr_Format(PyExc_MemoryError, "Failed to parse string: allocation failure\nposition: %d", input_buffer->offset);
-                goto fail; /* allocation failure */
-            }
-            buffer_ptr = malloc_ptr;
+        for (i = stack_base; i < input_buffer->value_stack_top; i++) {
+            PyList_SET_ITEM(item, i - stack_base, input_buffer->value_stack[i]);
         }
+        input_buffer->value_stack_top = stack_base;
+        input_buffer->depth--;
+        return item;
     }
 
-    buffer_writer = buffer_ptr;
-    /* loop through the string literal */
-    while (input_pointer < input_end) {
-        if (*input_pointer != '\\') {
-            *buffer_writer++ = *input_pointer++;
+    /* the member count is known now, fill a dict that never has to resize */
+#if PY_VERSION_HEX < 0x030D0000
+    item = _PyDict_NewPresized((input_buffer->value_stack_top - stack_base) / 2);
+#else
+    item = PyDict_New();
+#endif
+    if (item == NULL) {
+        return NULL;
+    }
+    for (i = stack_base; i < input_buffer->value_stack_top; i += 2) {
+        if (PyDict_SetItem(item, input_buffer->value_stack[i], input_buffer->value_stack[i + 1]) < 0) {
+            Py_DECREF(item);
+            return NULL;
         }
-        /* escape sequence */
-        else {
-            unsigned char sequence_length = 2;
-            if ((input_end - input_pointer) < 1) {
-                PyErr_Format(PyExc_ValueError, "Failed to parse string: buffer overflow\nposition: %d", input_buffer->offset);
-                goto fail;
-            }
-            unsigned char this_char = input_pointer[1];
-            switch (this_char) {
-                PARSE_STRING_CHAR_MATCHER(this_char);
-                /* UTF-16 literal */
-                case 'u':
-                    sequence_length = utf16_literal_to_utf8(input_pointer, input_end, &buffer_writer);
-                    if (sequence_length == 0) {
-                        /* failed to convert UTF16-literal to UTF-8 */
-                        PyErr_Format(PyExc_ValueError, "Failed to parse string: invalid UTF-16\nposition: %d", input_buffer->offset);
-                        goto fail;
-                    }
-                    break;
+    }
+    pop_values(input_buffer, stack_base);
+    input_buffer->depth--;
 
-                default:
-                    PyErr_Format(PyExc_ValueError, "Failed to parse string: invalid escape sequence(%d)\nposition: %d", input_pointer[1], input_buffer->offset);
-                    goto fail;
-            }
-            input_pointer += sequence_length;
+    if (input_buffer->object_hook) {
+        PyObject *re = PyObject_CallFunctionObjArgs(input_buffer->object_hook, item, NULL);
+        Py_DECREF(item);
+        if (re == NULL) {
+            PyErr_Format(PyExc_ValueError, "Failed to parse dictionary: object_hook failed\nposition: %zd", error_position(input_buffer));
+            return NULL;
         }
+        item = re;
     }
+    return item;
+}
 
-    /* zero terminate the output */
-    *buffer_writer = '\0';
-    *item = PyUnicode_FromString((char *) buffer_ptr);
-
-    input_buffer->offset = (Py_ssize_t) (input_end - input_buffer->content);
+/* allocate the key cache on the first use */
+static bool ensure_key_cache(parse_buffer *const input_buffer) {
+    if (input_buffer->key_cache == NULL) {
+        input_buffer->key_cache = (key_cache_entry *) input_buffer->hooks.allocate(KEY_CACHE_SIZE * sizeof(key_cache_entry));
+        if (input_buffer->key_cache == NULL) {
+            PyErr_Format(PyExc_MemoryError, "Failed to parse dictionary: allocation failure\nposition: %zd", error_position(input_buffer));
+            return false;
+        }
+        memset(input_buffer->key_cache, 0, KEY_CACHE_SIZE * sizeof(key_cache_entry));
+    }
+    return true;
+}
 
-success:
-    PARSE_STRING_FINALIZE;
+/* forget the cached keys, their raw characters must not be compared once the input they point into is gone */
+static void key_cache_clear(parse_buffer *const buffer) {
+    Py_ssize_t i;
 
-    input_buffer->offset++;
+    if (buffer->key_cache == NULL) {
+        return;
+    }
+    for (i = 0; i < KEY_CACHE_SIZE; i++) {
+        Py_CLEAR(buffer->key_cache[i].key);
+    }
+}
 
-    return true;
+/* release the scratch memory owned by a parse_buffer */
+static void parse_buffer_free(parse_buffer *const buffer) {
+    if (buffer->string_buffer != NULL) {
+        buffer->hooks.deallocate(buffer->string_buffer);
+        buffer->string_buffer = NULL;
+    }
+    if (buffer->key_cache != NULL) {
+        key_cache_clear(buffer);
+        buffer->hooks.deallocate(buffer->key_cache);
+        buffer->key_cache = NULL;
+    }
+    if (buffer->value_stack != NULL) {
+        pop_values(buffer, 0);
+        buffer->hooks.deallocate(buffer->value_stack);
+        buffer->value_stack = NULL;
+    }
+    if (buffer->containers != NULL) {
+        buffer->hooks.deallocate(buffer->containers);
+        buffer->containers = NULL;
+    }
+}
 
-fail:
-    PARSE_STRING_FINALIZE;
+/* characters the number scanner below takes as part of a number */
+#define is_number_char(c) ((((c) >= '0') && ((c) <= '9')) || ((c) == '.') || ((c) == 'e') || ((c) == 'E') || ((c) == '+') || ((c) == '-'))
 
-    if (input_pointer != NULL) {
-        input_buffer->offset = (Py_ssize_t) (input_pointer - input_buffer->content);
-    }
+#if PY_LITTLE_ENDIAN
+/* check if the 8 bytes at input are all ASCII digits */
+static inline bool is_eight_digits(const unsigned char *const input) {
+    uint64_t value;
+    memcpy(&value, input, 8);
+    return (((value & 0xF0F0F0F0F0F0F0F0) | (((value + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333);
+}
 
-    return false;
+/* the value of 8 ASCII digits, combining neighbouring digits pairwise with three multiplications */
+static inline uint32_t parse_eight_digits(const unsigned char *const input) {
+    const uint64_t mask = 0x000000FF000000FF;
+    const uint64_t mul1 = 0x000F424000000064; /* 100 + (1000000 << 32) */
+    const uint64_t mul2 = 0x0000271000000001; /* 1 + (10000 << 32) */
+    uint64_t value;
+    memcpy(&value, input, 8);
+    value -= 0x3030303030303030;
+    value = (value * 10) + (value >> 8);
+    value = (((value & mask) * mul1) + (((value >> 16) & mask) * mul2)) >> 32;
+    return (uint32_t) value;
 }
-#undef PARSE_STRING_FINALIZE
-#undef PARSE_STRING_CHAR_MATCHER
+#endif
 
-/* Build an array from input text. */
-static bool parse_array(PyObject **item, parse_buffer *const input_buffer) {
-    assert(item);
-    if (input_buffer->depth >= CJSON_NESTING_LIMIT) {
-        PyErr_Format(PyExc_ValueError, "Failed to parse array: too deeply nested\nposition: %d", input_buffer->offset);
-        return false; /* to deeply nested */
-    }
-    input_buffer->depth++;
+/* what the fast path made of a number */
+typedef enum number_kind {
+    NUMBER_OTHER, /* the number has to be converted by the general path, or is invalid */
+    NUMBER_INTEGER,
+    NUMBER_FLOAT
+} number_kind;
 
-    if (buffer_at_offset(input_buffer)[0] != '[') {
-        /* not an array */
-        PyErr_Format(PyExc_ValueError, "Failed to parse array: it is not an array\nposition: %d", input_buffer->offset);
-        goto fail;
+/* Convert integers of up to 18 digits directly, and floats by Clinger's fast path or Eisel-Lemire.
+ * The value and the length of the number are set unless NUMBER_OTHER is returned. It does not need the GIL. */
+static inline number_kind parse_number_fast(const unsigned char *const starting_point, const unsigned char *const input_end, long long *integer, double *number, Py_ssize_t *length) {
+    const unsigned char *input_pointer = starting_point + (starting_point[0] == '-');
+    const unsigned char *const digits_start = input_pointer;
+    uint64_t value = 0;
+#if PY_LITTLE_ENDIAN
+    while (((input_end - input_pointer) >= 8) && is_eight_digits(input_pointer)) {
+        value = (value * 100000000) + parse_eight_digits(input_pointer);
+        input_pointer += 8;
     }
-
-    input_buffer->offset++;
-    buffer_skip_whitespace(input_buffer);
-    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ']')) {
-        /* empty array */
-        *item = PyList_New(0);
-        goto success;
+#endif
+    while ((input_pointer < input_end) && (*input_pointer >= '0') && (*input_pointer <= '9')) {
+        value = (value * 10) + (uint64_t) (*input_pointer - '0');
+        input_pointer++;
     }
-
-    /* check if we skipped to the end of the buffer */
-    if (cannot_access_at_index(input_buffer, 0)) {
-        input_buffer->offset--;
-        PyErr_Format(PyExc_ValueError, "Failed to parse array: buffer overflow\nposition: %d", input_buffer->offset);
-        goto fail;
+    if ((input_pointer > digits_start) && ((input_pointer - digits_start) <= 18) &&
+        ((input_pointer == input_end) || !(is_number_char(*input_pointer)))) {
+        *integer = (starting_point[0] == '-') ? -(long long) value : (long long) value;
+        *length = (Py_ssize_t) (input_pointer - starting_point);
+        return NUMBER_INTEGER;
     }
-    /* step back to character in front of the first element */
-    input_buffer->offset--;
-    *item = PyList_New(0);
-    /* loop through the comma separated array elements */
-    do {
-        /* parse next value */
-        input_buffer->offset++;
-        buffer_skip_whitespace(input_buffer);
-        PyObject *buffer = NULL;
-        if (!parse_value(&buffer, input_buffer)) {
-            goto fail; /* failed to parse value */
+    /* double-conversion only gets the floats these cannot decide */
+    if ((input_pointer < input_end) && ((*input_pointer == '.') || (*input_pointer == 'e') || (*input_pointer == 'E'))) {
+        const size_t float_length = float_parse(starting_point, input_end, number);
+        input_pointer = starting_point + float_length;
+        if ((float_length > 0) &&
+            ((input_pointer == input_end) || !(is_number_char(*input_pointer)))) {
+            *length = (Py_ssize_t) float_length;
+            return NUMBER_FLOAT;
         }
-        buffer_skip_whitespace(input_buffer);
-        PyList_Append(*item, buffer);
-        Py_DECREF(buffer);
-    } while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
-    if (cannot_access_at_index(input_buffer, 0) || buffer_at_offset(input_buffer)[0] != ']') {
-        PyErr_Format(PyExc_ValueError, "Failed to parse array: expected end of array\nposition: %d", input_buffer->offset);
-        goto fail; /* expected end of array */
     }
+    return NUMBER_OTHER;
+}
 
-success:
-    input_buffer->depth--;
-
-    input_buffer->offset++;
-
-    return true;
-
-fail:
-    Py_XDECREF(*item);
-    *item = NULL;
+/* Check the number at start that the fast path could not convert as parse_number_ascii does. length is set to its run
+ * of number characters, processed to how many of them double-conversion takes if it is a float, -1 otherwise.
+ * It does not need the GIL. */
+static bool check_number_run(const unsigned char *const start, const unsigned char *const end, Py_ssize_t *length, int *processed) {
+    Py_ssize_t digits;
+    bool dec = false;
 
-    return false;
+    *length = 0;
+    *processed = -1;
+    while ((start + *length < end) && is_number_char(start[*length])) {
+        dec |= (start[*length] == '.') || (start[*length] == 'e') || (start[*length] == 'E');
+        (*length)++;
+    }
+    if (dec) {
+        *processed = 0;
+        dconv_s2d_json((const char *) start, (int) *length, processed);
+        return *processed == *length;
+    }
+    /* what PyLong_FromString takes whole */
+    digits = (start[0] == '-');
+    while ((digits < *length) && (start[digits] >= '0') && (start[digits] <= '9')) {
+        digits++;
+    }
+    return (digits == *length) && (*length > (start[0] == '-'));
 }
 
-/* Parse the input text to generate a number, and populate the result into item. */
+/* Parse the number at starting_point, which ends no later than input_end, and populate the result into item.
+ * The bytes can be the input itself or a narrowed copy of it, the offset of input_buffer is advanced past the number. */
 /* Note: it will NOT throw overflow error when double overflow, it will return inf instead. */
-static bool parse_number(PyObject **item, parse_buffer *const input_buffer) {
+static bool parse_number_ascii(PyObject **item, parse_buffer *const input_buffer, const unsigned char *const starting_point, const unsigned char *const input_end) {
     assert(item);
-    unsigned char *after_end = NULL;
-    unsigned char old_ending = '\x0';
     Py_ssize_t i = 0;
+    Py_ssize_t length = 0;
     bool dec = false;
-    const unsigned char *starting_point = buffer_at_offset(input_buffer);
+    long long integer = 0;
+    double number = 0.0;
 
-    if ((input_buffer == NULL) || (input_buffer->content == NULL)) {
-        PyErr_Format(PyExc_ValueError, "Failed to parse number: no input\nposition: %d", input_buffer->offset);
-        return false;
+    const number_kind kind = parse_number_fast(starting_point, input_end, &integer, &number, &length);
+
+    if (kind != NUMBER_OTHER) {
+        *item = (kind == NUMBER_INTEGER) ? PyLong_FromLongLong(integer) : PyFloat_FromDouble(number);
+        if (*item == NULL) {
+            return false;
+        }
+        input_buffer->offset += length;
+        return true;
     }
 
-    /* copy the number into a temporary buffer and replace '.' with the decimal point
-     * of the current locale (for strtod)
-     * This also takes care of '\0' not necessarily being available for marking the end of the input */
-    for (i = 0; can_access_at_index(input_buffer, i); i++) {
-        switch (buffer_at_offset(input_buffer)[i]) {
+    /* find the length of the number, the input does not have to be terminated after it */
+    for (i = 0; starting_point + i < input_end; i++) {
+        switch (starting_point[i]) {
             case '.':
             case 'E':
             case 'e':
@@ -478,361 +709,3781 @@ static bool parse_number(PyObject **item, parse_buffer *const input_buffer) {
         }
     }
 loop_end:
-    // there is already a null terminator at the end of the buffer
-    if (input_buffer->offset + i != input_buffer->length) {
-        if (!can_access_at_index(input_buffer, i) || i == 0) {
-            PyErr_Format(PyExc_ValueError, "Failed to parse number: expected character after number\nposition: %d", input_buffer->offset);
-            return false;
-        }
-        old_ending = buffer_at_offset(input_buffer)[i];
-        *((char *) (buffer_at_offset(input_buffer) + i)) = '\0';
+    if (i == 0) {
+        PyErr_Format(PyExc_ValueError, "Failed to parse number: expected character after number\nposition: %zd", error_position(input_buffer));
+        return false;
     }
 
+    /* the input is never written to, the number is converted from its length or from a terminated copy */
     if (dec) {
-        // const double temp = PyOS_string_to_double((const char *) starting_point, (char **) &after_end, PyExc_OverflowError);
-        // if (PyErr_Occurred()) return false;
-        if (dconv_s2d_ptr == NULL) {
-            dconv_s2d_init(&dconv_s2d_ptr, NO_FLAGS, 0.0, Py_NAN, "Infinity", "NaN");
-        }
         int processed_characters_count = 0;
-        const double temp = dconv_s2d(dconv_s2d_ptr, (const char *) starting_point, i, &processed_characters_count);
+        const double temp = dconv_s2d_json((const char *) starting_point, (int) i, &processed_characters_count);
         if (i != processed_characters_count) {
-            PyErr_Format(PyExc_ValueError, "Failed to parse number: invalid number, only can parse (%d/%d)\nposition: %d", processed_characters_count, i, input_buffer->offset);
-            goto fail;
+            PyErr_Format(PyExc_ValueError, "Failed to parse number: invalid number, only can parse (%d/%zd)\nposition: %zd", processed_characters_count, i, error_position(input_buffer));
+            return false;
         }
-        after_end = (unsigned char *) (starting_point + processed_characters_count);
+        length = processed_characters_count;
         *item = PyFloat_FromDouble(temp);
-    } else
-        *item = PyLong_FromString((const char *) starting_point, (char **) &after_end, 10);
-    if (starting_point == after_end || NULL == *item) {
-        PyErr_Format(PyExc_ValueError, "Failed to parse number: invalid number\nposition: %d", input_buffer->offset);
-        goto fail;
+    } else {
+        /* PyLong_FromString needs a terminated string */
+        char *after_end = NULL;
+        if (!ensure_string_buffer(input_buffer, i + 1)) {
+            return false;
+        }
+        memcpy(input_buffer->string_buffer, starting_point, (size_t) i);
+        input_buffer->string_buffer[i] = '\0';
+        *item = PyLong_FromString((const char *) input_buffer->string_buffer, &after_end, 10);
+        length = (after_end == NULL) ? 0 : (Py_ssize_t) (after_end - (char *) input_buffer->string_buffer);
+    }
+    if (length == 0 || NULL == *item) {
+        Py_XDECREF(*item);
+        *item = NULL;
+        PyErr_Format(PyExc_ValueError, "Failed to parse number: invalid number\nposition: %zd", error_position(input_buffer));
+        return false;
     }
 
-    // restore the old ending, if it was overwritten, otherwise it will set null terminator again
-    *((char *) (buffer_at_offset(input_buffer) + i)) = old_ending;
-    input_buffer->offset += (Py_ssize_t) (after_end - starting_point);
+    input_buffer->offset += length;
     return true;
-
-fail:
-    *((char *) (buffer_at_offset(input_buffer) + i)) = old_ending;
-    return false;
 }
 
-/* Build an object from the text. */
-static bool parse_object(PyObject **item, parse_buffer *const input_buffer) {
-    assert(item);
-    if (input_buffer->depth >= CJSON_NESTING_LIMIT) {
-        PyErr_Format(PyExc_ValueError, "Failed to parse dictionary: too deeply nested\nposition: %d", input_buffer->offset);
-        return false; /* to deeply nested */
-    }
-    input_buffer->depth++;
-
-    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '{')) {
-        PyErr_Format(PyExc_ValueError, "Failed to parse dictionary: it is not an object\nposition: %d", input_buffer->offset);
-        goto fail; /* not an object */
-    }
+/* Handle the error set by parsing line lineno of JSON Lines input. Returns false if it has to be raised, else item is
+ * NULL for a skipped line or the error for a collected one. Errors other than ValueError are always raised. */
+static bool handle_line_error(line_errors errors, Py_ssize_t lineno, PyObject **item) {
+    PyObject *exception = NULL;
+    PyObject *number = NULL;
 
-    input_buffer->offset++;
-    buffer_skip_whitespace(input_buffer);
-    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '}')) {
-        /* empty object */
-        *item = PyDict_New();
-        goto success;
+    *item = NULL;
+    if ((errors == LINE_ERRORS_RAISE) || !PyErr_ExceptionMatches(PyExc_ValueError)) {
+        return false;
     }
-
-    /* check if we skipped to the end of the buffer */
-    if (cannot_access_at_index(input_buffer, 0)) {
-        input_buffer->offset--;
-        PyErr_Format(PyExc_ValueError, "Failed to parse dictionary: buffer overflow\nposition: %d", input_buffer->offset);
-        goto fail;
+    if (errors == LINE_ERRORS_SKIP) {
+        PyErr_Clear();
+        return true;
     }
-    *item = PyDict_New();
-    /* step back to character in front of the first element */
-    input_buffer->offset--;
-    /* loop through the comma separated array elements */
-    do {
-        /* parse the name of the child */
-        input_buffer->offset++;
-        buffer_skip_whitespace(input_buffer);
-        PyObject *keyBuffer = NULL;
-        if (!parse_string(&keyBuffer, input_buffer)) {
-            goto fail; /* failed to parse name */
-        }
-        buffer_skip_whitespace(input_buffer);
-
-        if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':')) {
-            PyErr_Format(PyExc_ValueError, "Failed to parse dictionary: expected colon\nposition: %d", input_buffer->offset);
-            goto fail; /* invalid object */
-        }
 
-        /* parse the value */
-        input_buffer->offset++;
-        buffer_skip_whitespace(input_buffer);
-        PyObject *valueBuffer = NULL;
-        if (!parse_value(&valueBuffer, input_buffer)) {
-            goto fail; /* failed to parse value */
+#if PY_VERSION_HEX >= 0x030C0000
+    exception = PyErr_GetRaisedException();
+#else
+    {
+        PyObject *type = NULL;
+        PyObject *traceback = NULL;
+        PyErr_Fetch(&type, &exception, &traceback);
+        PyErr_NormalizeException(&type, &exception, &traceback);
+        if (traceback != NULL) {
+            PyException_SetTraceback(exception, traceback);
         }
-        buffer_skip_whitespace(input_buffer);
-        PyDict_SetItem(*item, keyBuffer, valueBuffer);
-        Py_DECREF(valueBuffer);
-        Py_DECREF(keyBuffer);
-    } while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
-
-    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '}')) {
-        PyErr_Format(PyExc_ValueError, "Failed to parse dictionary: expected end of object\nposition: %d", input_buffer->offset);
-        goto fail; /* expected end of object */
+        Py_XDECREF(type);
+        Py_XDECREF(traceback);
     }
-
-success:
-    input_buffer->depth--;
-
-    input_buffer->offset++;
-
-    if (input_buffer->object_hook) {
-        PyObject *re = PyObject_CallFunctionObjArgs(input_buffer->object_hook, *item, NULL);
-        if (re == NULL) {
-            PyErr_Format(PyExc_ValueError, "Failed to parse dictionary: object_hook failed\nposition: %d", input_buffer->offset);
-            goto fail;
-        }
-        *item = re;
+#endif
+    number = PyLong_FromSsize_t(lineno);
+    if ((number == NULL) || (PyObject_SetAttrString(exception, "lineno", number) < 0)) {
+        Py_XDECREF(number);
+        Py_DECREF(exception);
+        return false;
     }
+    Py_DECREF(number);
+    *item = exception;
     return true;
+}
 
-fail:
-    Py_XDECREF(*item);
-    *item = NULL;
+/* why validate or skip_value found a value invalid */
+typedef struct validate_error {
+    const char *message; /* the error of the parser, a format taking the two arguments */
+    int arguments[2];
+    Py_ssize_t position; /* in the code units of the input, as the parser counts them */
+    bool at_end; /* extra characters after the document, reported at the end of the document */
+    Py_ssize_t lineno;
+    Py_ssize_t colno;
+} validate_error;
 
+static inline bool validate_fail(validate_error *const error, const char *message, Py_ssize_t position) {
+    error->message = message;
+    error->position = position;
     return false;
 }
 
-/* Parser core - when encountering text, process appropriately. */
-static bool parse_value(PyObject **item, parse_buffer *const input_buffer) {
-    assert(item);
-    if ((input_buffer == NULL) || (input_buffer->content == NULL)) {
-        PyErr_Format(PyExc_ValueError, "Failed to parse value: no input\nposition: %d", input_buffer->offset);
-        return false; /* no input */
-    }
-
-    /* parse the different types of values */
-    /* string */
-    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '\"')) {
-        return parse_string(item, input_buffer);
-    }
-    /* number */
-    if (can_access_at_index(input_buffer, 0) && ((buffer_at_offset(input_buffer)[0] == '-') || ((buffer_at_offset(input_buffer)[0] >= '0') && (buffer_at_offset(input_buffer)[0] <= '9')))) {
-        /* -Infinity */
-        if (can_read(input_buffer, 9) && (strncmp((const char *) buffer_at_offset(input_buffer), "-Infinity", 9) == 0)) {
-            *item = PyFloat_FromDouble(-INFINITY);
-            input_buffer->offset += 9;
-            return true;
-        }
-        return parse_number(item, input_buffer);
-    }
-    /* array */
-    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '[')) {
-        return parse_array(item, input_buffer);
-    }
-    /* object */
-    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '{')) {
-        return parse_object(item, input_buffer);
-    }
-    /* null */
-    if (can_read(input_buffer, 4) && (strncmp((const char *) buffer_at_offset(input_buffer), "null", 4) == 0)) {
-        Py_INCREF(Py_None);
-        *item = Py_None;
-        input_buffer->offset += 4;
-        return true;
+/* raise the error of the parser for an invalid value, at its position plus origin */
+static void raise_validate_error(const validate_error *const error, Py_ssize_t origin) {
+    PyObject *message = NULL;
+
+    if (error->message == NULL) {
+        PyErr_NoMemory();
+        return;
     }
-    /* false */
-    if (can_read(input_buffer, 5) && (strncmp((const char *) buffer_at_offset(input_buffer), "false", 5) == 0)) {
-        Py_INCREF(Py_False);
-        *item = Py_False;
-        input_buffer->offset += 5;
-        return true;
+    message = PyUnicode_FromFormat(error->message, error->arguments[0], error->arguments[1]);
+    if (message != NULL) {
+        PyErr_Format(PyExc_ValueError, "%U\nposition: %zd", message, origin + error->position);
+        Py_DECREF(message);
     }
-    /* true */
-    if (can_read(input_buffer, 4) && (strncmp((const char *) buffer_at_offset(input_buffer), "true", 4) == 0)) {
-        Py_INCREF(Py_True);
-        *item = Py_True;
-        input_buffer->offset += 4;
-        return true;
+}
+
+/* The most digits int takes from a string, sys.get_int_max_str_digits(). 0 for no limit, -1 with an error set. */
+static Py_ssize_t int_max_str_digits(void) {
+    PyObject *function = PySys_GetObject("get_int_max_str_digits"); /* borrowed, NULL before the limit existed */
+    PyObject *limit = NULL;
+    Py_ssize_t digits = 0;
+
+    if (function == NULL) {
+        return 0;
     }
-    /* Infinity */
-    if (can_read(input_buffer, 8) && (strncmp((const char *) buffer_at_offset(input_buffer), "Infinity", 8) == 0)) {
-        *item = PyFloat_FromDouble(INFINITY);
-        input_buffer->offset += 8;
-        return true;
+    limit = PyObject_CallObject(function, NULL);
+    if (limit == NULL) {
+        return -1;
     }
-    /* NaN */
-    if (can_read(input_buffer, 3) && (strncmp((const char *) buffer_at_offset(input_buffer), "NaN", 3) == 0)) {
-        *item = PyFloat_FromDouble(Py_NAN);
-        input_buffer->offset += 3;
+    digits = PyLong_AsSsize_t(limit);
+    Py_DECREF(limit);
+    return digits;
+}
+
+/* the parser, instantiated in the style of CPython's stringlib for every representation of the input:
+ * UTF-8 for bytes-like objects and ASCII str, and the 1, 2 and 4 byte kinds of any other str */
+#define CHAR_T Py_UCS1
+#define CHAR_SIZE 1
+#define DECODE_UTF8 1
+#define PARSER(name) name##_utf8
+#include "pycJSON_decode_template.h"
+
+#define CHAR_T Py_UCS1
+#define CHAR_SIZE 1
+#define DECODE_UTF8 0
+#define PARSER(name) name##_ucs1
+#include "pycJSON_decode_template.h"
+
+#define CHAR_T Py_UCS2
+#define CHAR_SIZE 2
+#define DECODE_UTF8 0
+#define PARSER(name) name##_ucs2
+#include "pycJSON_decode_template.h"
+
+#define CHAR_T Py_UCS4
+#define CHAR_SIZE 4
+#define DECODE_UTF8 0
+#define PARSER(name) name##_ucs4
+#include "pycJSON_decode_template.h"
+
+/* Parallel decoding of JSON Lines and of large arrays. The input is split into chunks. Worker threads scan the chunks
+ * without the GIL into tapes: the tokens of the lines or elements, validated, with numbers converted and strings
+ * measured. The calling thread turns the tapes into Python objects in order, while the workers scan the next chunks. */
+#define PARALLEL_CHUNK_SIZE (1 << 20) /* bytes of input per tape, what bounds the memory of the tapes */
+#define TAPE_SIZE 4096
+
+/* the kinds of the entries of a tape */
+typedef enum tape_type {
+    TAPE_LINE, /* a line with a valid document, the entries of the document follow */
+    TAPE_INVALID_LINE, /* a line that is parsed again on the calling thread for its error */
+    TAPE_ARRAY,
+    TAPE_OBJECT,
+    TAPE_END, /* of the innermost open array or object */
+    TAPE_NULL,
+    TAPE_TRUE,
+    TAPE_FALSE,
+    TAPE_INFINITY,
+    TAPE_NEGATIVE_INFINITY,
+    TAPE_NAN,
+    TAPE_INTEGER,
+    TAPE_FLOAT,
+    TAPE_NUMBER, /* a number the fast path cannot convert */
+    TAPE_STRING,
+    TAPE_KEY
+} tape_type;
+
+/* what a worker found out about a token */
+typedef struct tape_entry {
+    unsigned char type;
+    bool raw; /* strings: no escape sequences, the bytes are the UTF-8 of the result */
+    Py_UCS4 maxchar; /* strings: the widest character of the result */
+    Py_ssize_t start; /* where lines, strings (after the quote) and numbers start, where arrays and objects end */
+    Py_ssize_t length; /* of lines, strings and numbers in the input, arrays and objects: entries up to their end */
+    union {
+        long long integer;
+        double number;
+        Py_ssize_t output_length; /* strings: the length of the result */
+        Py_ssize_t lineno; /* lines: the number of the line in its chunk, starting with 1 */
+        Py_ssize_t count; /* arrays and objects: the number of values or members */
+    } value;
+} tape_entry;
+
+/* the entries of the lines or elements of one chunk, only touched by one thread at a time */
+typedef struct tape {
+    tape_entry *entries;
+    Py_ssize_t size;
+    Py_ssize_t capacity;
+    Py_ssize_t *containers; /* the entries of the open arrays and objects of the value being scanned */
+    Py_ssize_t containers_size;
+    Py_ssize_t lines; /* JSON Lines: in the chunk, blank ones included */
+    Py_ssize_t start; /* arrays: where the elements on the tape start, -1 if none start in the chunk */
+    Py_ssize_t end; /* arrays: the comma after them, or the bracket closing the array */
+    bool closed; /* arrays: end is the closing bracket */
+    bool invalid; /* arrays: the elements are not valid up to end, the parser tells why */
+    bool failed; /* out of memory */
+} tape;
+
+/* make room for one more entry, the tape is allocated without the GIL */
+static bool tape_reserve(tape *const t) {
+    tape_entry *new_entries = NULL;
+    Py_ssize_t new_capacity;
+
+    if (t->size < t->capacity) {
         return true;
     }
-    /* -NaN */
-    if (can_read(input_buffer, 4) && (strncmp((const char *) buffer_at_offset(input_buffer), "-NaN", 4) == 0)) {
-        *item = PyFloat_FromDouble(Py_NAN);
-        input_buffer->offset += 4;
-        return true;
+    new_capacity = (t->capacity == 0) ? TAPE_SIZE : t->capacity * 2;
+    new_entries = (tape_entry *) PyMem_RawRealloc(t->entries, (size_t) new_capacity * sizeof(tape_entry));
+    if (new_entries == NULL) {
+        return false;
     }
+    t->entries = new_entries;
+    t->capacity = new_capacity;
+    return true;
+}
 
-    PyErr_Format(PyExc_ValueError, "Failed to parse value: invalid value\nposition: %d", input_buffer->offset);
+/* append an entry, room for it has been reserved */
+static inline tape_entry *tape_push(tape *const t, tape_type type, Py_ssize_t start) {
+    tape_entry *const entry = &t->entries[t->size++];
+    entry->type = (unsigned char) type;
+    entry->start = start;
+    return entry;
+}
 
-    return false;
+/* append the end of the container whose entry is at open */
+static inline void tape_push_end(tape *const t, Py_ssize_t open, Py_ssize_t start) {
+    tape_push(t, TAPE_END, start);
+    t->entries[open].length = t->size - 1 - open;
 }
 
-PyObject *pycJSON_Decode(PyObject *self, PyObject *args, PyObject *kwargs) {
-    parse_buffer buffer = {0, 0, 0, 0, {0, 0}, 0};
-    PyObject *item = NULL;
+/* skip the whitespace the parser skips */
+static inline const unsigned char *tape_skip_whitespace(const unsigned char *pointer, const unsigned char *const line_end) {
+    while ((pointer < line_end) && (*pointer <= 32)) {
+        pointer++;
+    }
+    return pointer;
+}
+
+/* validate and measure the string at pointer, which is left after its closing quote */
+static bool tape_scan_string(tape *const t, tape_type type, const unsigned char *const content, const unsigned char **pointer, const unsigned char *const line_end) {
+    const unsigned char *const input_start = *pointer + 1;
+    const unsigned char *input_pointer = input_start + scan_string_ascii(input_start, line_end);
+    Py_ssize_t output_length = input_pointer - input_start;
+    Py_UCS4 maxchar = 127;
+    bool raw = true;
+    tape_entry *entry = NULL;
+
+    if ((input_pointer >= line_end) || (*input_pointer != '\"')) {
+        if (measure_string_utf8(&input_pointer, line_end, &output_length, &maxchar) != STRING_VALID) {
+            return false;
+        }
+        raw = (memchr(input_start, '\\', (size_t) (input_pointer - input_start)) == NULL);
+    }
+    entry = tape_push(t, type, input_start - content);
+    entry->raw = raw;
+    entry->maxchar = maxchar;
+    entry->length = input_pointer - input_start;
+    entry->value.output_length = output_length;
+    *pointer = input_pointer + 1;
+    return true;
+}
+
+/* Scan the value at *value_pointer onto the tape, leaving *value_pointer after it. Returns false if the value is
+ * invalid, or if out of memory, which sets t->failed. The checks are the ones of parse_value, so that a value is valid
+ * here exactly when the parser accepts it. */
+static bool tape_scan_value(tape *const t, const unsigned char *const content, const unsigned char **value_pointer, const unsigned char *const end, Py_ssize_t max_depth) {
+    const unsigned char *pointer = *value_pointer;
+    Py_ssize_t depth = 0;
+    parse_state state = STATE_VALUE;
+
+    for (;;) {
+        if (!tape_reserve(t)) {
+            t->failed = true;
+            return false;
+        }
+        switch (state) {
+            case STATE_VALUE:
+                if (pointer >= end) {
+                    return false;
+                }
+                switch (*pointer) {
+                    case '[':
+                    case '{':
+                        if (depth >= max_depth) {
+                            return false;
+                        }
+                        if (depth == t->containers_size) {
+                            const Py_ssize_t new_size = (t->containers_size == 0) ? CONTAINER_STACK_SIZE : t->containers_size * 2;
+                            Py_ssize_t *new_containers = (Py_ssize_t *) PyMem_RawRealloc(t->containers, (size_t) new_size * sizeof(Py_ssize_t));
+                            if (new_containers == NULL) {
+                                t->failed = true;
+                                return false;
+                            }
+                            t->containers = new_containers;
+                            t->containers_size = new_size;
+                        }
+                        t->containers[depth++] = t->size;
+                        tape_push(t, (*pointer == '{') ? TAPE_OBJECT : TAPE_ARRAY, pointer - content)->value.count = 0;
+                        state = (*pointer == '{') ? STATE_OBJECT_START : STATE_ARRAY_START;
+                        pointer = tape_skip_whitespace(pointer + 1, end);
+                        continue;
+                    case '\"':
+                        if (!tape_scan_string(t, TAPE_STRING, content, &pointer, end)) {
+                            return false;
+                        }
+                        break;
+                    case 'n':
+                        if (!match_at_utf8(pointer, end, "null", 4)) {
+                            return false;
+                        }
+                        tape_push(t, TAPE_NULL, pointer - content);
+                        pointer += 4;
+                        break;
+                    case 'f':
+                        if (!match_at_utf8(pointer, end, "false", 5)) {
+                            return false;
+                        }
+                        tape_push(t, TAPE_FALSE, pointer - content);
+                        pointer += 5;
+                        break;
+                    case 't':
+                        if (!match_at_utf8(pointer, end, "true", 4)) {
+                            return false;
+                        }
+                        tape_push(t, TAPE_TRUE, pointer - content);
+                        pointer += 4;
+                        break;
+                    case 'I':
+                        if (!match_at_utf8(pointer, end, "Infinity", 8)) {
+                            return false;
+                        }
+                        tape_push(t, TAPE_INFINITY, pointer - content);
+                        pointer += 8;
+                        break;
+                    case 'N':
+                        if (!match_at_utf8(pointer, end, "NaN", 3)) {
+                            return false;
+                        }
+                        tape_push(t, TAPE_NAN, pointer - content);
+                        pointer += 3;
+                        break;
+                    case '-':
+                        if (match_at_utf8(pointer, end, "-Infinity", 9)) {
+                            tape_push(t, TAPE_NEGATIVE_INFINITY, pointer - content);
+                            pointer += 9;
+                            break;
+                        }
+                        /* fall through */
+                    case '0':
+                    case '1':
+                    case '2':
+                    case '3':
+                    case '4':
+                    case '5':
+                    case '6':
+                    case '7':
+                    case '8':
+                    case '9': {
+                        long long integer = 0;
+                        double number = 0.0;
+                        Py_ssize_t length = 0;
+                        const number_kind kind = parse_number_fast(pointer, end, &integer, &number, &length);
+
+                        if (kind == NUMBER_INTEGER) {
+                            tape_push(t, TAPE_INTEGER, pointer - content)->value.integer = integer;
+                        } else if (kind == NUMBER_FLOAT) {
+                            tape_push(t, TAPE_FLOAT, pointer - content)->value.number = number;
+                        } else {
+                            /* converted on the calling thread, the parser reports it if it is invalid */
+                            int processed = 0;
+                            if (!check_number_run(pointer, end, &length, &processed)) {
+                                return false;
+                            }
+                            tape_push(t, TAPE_NUMBER, pointer - content)->length = length;
+                        }
+                        pointer += length;
+                        break;
+                    }
+                    default:
+                        return false;
+                }
+                break;
+
+            case STATE_ARRAY_START:
+            case STATE_OBJECT_START:
+                if ((pointer < end) && (*pointer == ((state == STATE_OBJECT_START) ? '}' : ']'))) {
+                    /* empty array or object */
+                    pointer++;
+                    tape_push_end(t, t->containers[--depth], pointer - content);
+                    break;
+                }
+                state = (state == STATE_OBJECT_START) ? STATE_KEY : STATE_VALUE;
+                continue;
+
+            case STATE_KEY:
+                if ((pointer >= end) || (*pointer != '\"') || !tape_scan_string(t, TAPE_KEY, content, &pointer, end)) {
+                    return false;
+                }
+                pointer = tape_skip_whitespace(pointer, end);
+                state = STATE_COLON;
+                continue;
+
+            case STATE_COLON:
+                if ((pointer >= end) || (*pointer != ':')) {
+                    return false;
+                }
+                pointer = tape_skip_whitespace(pointer + 1, end);
+                state = STATE_VALUE;
+                continue;
+
+            case STATE_NEXT:
+                if ((pointer < end) && (*pointer == ',')) {
+                    pointer = tape_skip_whitespace(pointer + 1, end);
+                    state = (t->entries[t->containers[depth - 1]].type == TAPE_OBJECT) ? STATE_KEY : STATE_VALUE;
+                    continue;
+                }
+                if ((pointer >= end) || (*pointer != ((t->entries[t->containers[depth - 1]].type == TAPE_OBJECT) ? '}' : ']'))) {
+                    return false;
+                }
+                pointer++;
+                tape_push_end(t, t->containers[--depth], pointer - content);
+                break;
+        }
+
+        /* a value is complete */
+        if (depth == 0) {
+            break;
+        }
+        t->entries[t->containers[depth - 1]].value.count++;
+        pointer = tape_skip_whitespace(pointer, end);
+        state = STATE_NEXT;
+    }
+    *value_pointer = pointer;
+    return true;
+}
+
+/* Scan the line between start and end onto the tape, or mark it as invalid. Returns false if out of memory. */
+static bool tape_scan_line(tape *const t, const unsigned char *const content, Py_ssize_t start, Py_ssize_t end, Py_ssize_t lineno, Py_ssize_t max_depth) {
+    const unsigned char *pointer = content + start;
+    const unsigned char *line_end = NULL;
+    const Py_ssize_t header = t->size;
+    tape_entry *entry = NULL;
+
+    while ((end > start) && (content[end - 1] <= 32)) {
+        end--;
+    }
+    if (end == start) {
+        return true; /* a blank line */
+    }
+    line_end = content + end;
+    if (!tape_reserve(t)) {
+        t->failed = true;
+        return false;
+    }
+    entry = tape_push(t, TAPE_LINE, start);
+    entry->length = end - start;
+    entry->value.lineno = lineno;
+    pointer += bom_length_utf8(pointer, line_end);
+    pointer = tape_skip_whitespace(pointer, line_end);
+    if (!tape_scan_value(t, content, &pointer, line_end, max_depth)) {
+        if (t->failed) {
+            return false;
+        }
+        goto invalid;
+    }
+    if (pointer != line_end) {
+        goto invalid; /* extra characters at the end */
+    }
+    return true;
+
+invalid:
+    t->size = header + 1;
+    t->entries[header].type = TAPE_INVALID_LINE;
+    return true;
+}
+
+/* where a chunk of a document starts, and what it starts in */
+typedef struct document_chunk {
+    Py_ssize_t start; /* never right after a backslash, so that the first character is not escaped */
+    bool quotes_odd; /* the chunk has an odd number of unescaped quotes */
+    Py_ssize_t depth_change[2]; /* over the chunk, if it starts outside [0] or inside [1] a string */
+    bool in_string; /* at start, from the prefix pass over the chunks before */
+    Py_ssize_t depth; /* at start, from the prefix pass over the chunks before */
+} document_chunk;
+
+/* the input and the threads of one parallel parse */
+typedef struct parallel_job {
+    const unsigned char *content;
+    Py_ssize_t length;
+    Py_ssize_t max_depth; /* of the values on the tapes */
+    Py_ssize_t chunks;
+    Py_ssize_t threads; /* chunk i is scanned by thread i % threads into slot i % (2 * threads) */
+    void (*scan)(tape *t, const struct parallel_job *job, Py_ssize_t index); /* scans chunk index onto a tape */
+    document_chunk *document; /* documents: chunks + 1 chunks, the last one starts at length */
+    Py_ssize_t elements_start; /* documents: after the bracket opening the array */
+    struct parallel_slot *slots;
+    struct parallel_worker *workers;
+    Py_ssize_t started; /* threads */
+    bool cancelled; /* the calling thread stopped taking tapes, only read and written under cancel_lock */
+    PyThread_type_lock cancel_lock;
+} parallel_job;
+
+/* a tape, handed between a worker and the calling thread */
+typedef struct parallel_slot {
+    tape tape;
+    PyThread_type_lock filled; /* held until the worker has scanned the chunk */
+    PyThread_type_lock empty; /* held until the calling thread has materialized the tape */
+} parallel_slot;
+
+typedef struct parallel_worker {
+    parallel_job *job;
+    Py_ssize_t index;
+    void (*run)(parallel_job *job, Py_ssize_t index); /* the work of thread index */
+    PyThread_type_lock finished; /* held until the thread exits */
+} parallel_worker;
+
+/* where chunk index of JSON Lines starts: after the first newline from index * PARALLEL_CHUNK_SIZE - 1 on */
+static Py_ssize_t line_chunk_start(const parallel_job *const job, Py_ssize_t index) {
+    const Py_ssize_t position = index * PARALLEL_CHUNK_SIZE - 1;
+    const unsigned char *newline = NULL;
+
+    if (index == 0) {
+        return 0;
+    }
+    if (position >= job->length) {
+        return job->length;
+    }
+    newline = (const unsigned char *) memchr(job->content + position, '\n', (size_t) (job->length - position));
+    return (newline == NULL) ? job->length : (Py_ssize_t) (newline - job->content) + 1;
+}
+
+/* scan the lines of a chunk onto a tape, without the GIL */
+static void tape_scan_lines(tape *const t, const parallel_job *const job, Py_ssize_t index) {
+    Py_ssize_t start = line_chunk_start(job, index);
+    const Py_ssize_t end = line_chunk_start(job, index + 1);
+
+    t->size = 0;
+    t->lines = 0;
+    t->failed = false;
+    while (start < end) {
+        const unsigned char *newline = (const unsigned char *) memchr(job->content + start, '\n', (size_t) (end - start));
+        const Py_ssize_t line_end = (newline == NULL) ? end : (Py_ssize_t) (newline - job->content);
+
+        t->lines++;
+        if (!tape_scan_line(t, job->content, start, line_end, t->lines, job->max_depth)) {
+            return;
+        }
+        start = line_end + 1;
+    }
+}
+
+/* Count the quotes and brackets of a chunk of a document for the prefix pass. Whether the chunk starts in a string is
+ * only known once the chunks before are counted, so the depth is counted for both cases. */
+static void document_chunk_count(parallel_job *const job, Py_ssize_t index) {
+    document_chunk *const chunk = &job->document[index];
+    const unsigned char *pointer = job->content + chunk->start;
+    const unsigned char *const end = job->content + job->document[index + 1].start;
+    int in_string = 0; /* relative to the start */
+    Py_ssize_t depth_change[2] = {0, 0};
+
+    while (pointer < end) {
+        switch (*pointer++) {
+            case '\\':
+                /* valid JSON only has backslashes in strings, they escape the next character */
+                pointer++;
+                break;
+            case '\"':
+                in_string ^= 1;
+                break;
+            case '[':
+            case '{':
+                depth_change[in_string]++;
+                break;
+            case ']':
+            case '}':
+                depth_change[in_string]--;
+                break;
+            default:
+                break;
+        }
+    }
+    chunk->quotes_odd = in_string;
+    chunk->depth_change[0] = depth_change[0];
+    chunk->depth_change[1] = depth_change[1];
+}
+
+static void document_count_chunks(parallel_job *const job, Py_ssize_t worker) {
+    Py_ssize_t index;
+
+    for (index = worker; index < job->chunks; index += job->threads) {
+        document_chunk_count(job, index);
+    }
+}
+
+/* Find the first comma between elements of the array in chunk index, or NULL if it has none. Where the chunk starts
+ * is known from the prefix pass if the document is valid, tape_scan_elements checks that it is. */
+static const unsigned char *document_find_comma(const parallel_job *const job, Py_ssize_t index) {
+    const document_chunk *const chunk = &job->document[index];
+    const unsigned char *pointer = job->content + chunk->start;
+    const unsigned char *const end = job->content + job->document[index + 1].start;
+    bool in_string = chunk->in_string;
+    Py_ssize_t depth = chunk->depth;
+
+    for (; pointer < end; pointer++) {
+        if (in_string) {
+            if (*pointer == '\\') {
+                pointer++;
+            } else if (*pointer == '\"') {
+                in_string = false;
+            }
+            continue;
+        }
+        switch (*pointer) {
+            case '\"':
+                in_string = true;
+                break;
+            case '[':
+            case '{':
+                depth++;
+                break;
+            case ']':
+            case '}':
+                depth--;
+                break;
+            case ',':
+                if (depth == 1) {
+                    return pointer;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return NULL;
+}
+
+/* Scan the elements of the array from the first comma in chunk index on, up to the first comma in a later chunk or
+ * the end of the array, onto a tape, without the GIL. Where the elements start and end is left in the tape. */
+static void tape_scan_elements(tape *const t, const parallel_job *const job, Py_ssize_t index) {
+    const unsigned char *const content = job->content;
+    const unsigned char *const end = content + job->length;
+    const Py_ssize_t next_chunk = job->document[index + 1].start;
+    const unsigned char *pointer = NULL;
+
+    t->size = 0;
+    t->failed = false;
+    t->invalid = false;
+    t->closed = false;
+    t->start = -1;
+    t->end = -1;
+    if (index == 0) {
+        pointer = content + job->elements_start;
+    } else {
+        pointer = document_find_comma(job, index);
+        if (pointer == NULL) {
+            return; /* the elements of the chunks before go on */
+        }
+        pointer++;
+    }
+    t->start = pointer - content;
+
+    for (;;) {
+        pointer = tape_skip_whitespace(pointer, end);
+        if (!tape_scan_value(t, content, &pointer, end, job->max_depth)) {
+            t->invalid = !t->failed;
+            return;
+        }
+        pointer = tape_skip_whitespace(pointer, end);
+        if ((pointer < end) && (*pointer == ',')) {
+            if (pointer - content >= next_chunk) {
+                break;
+            }
+            pointer++;
+            continue;
+        }
+        if ((pointer < end) && (*pointer == ']')) {
+            t->closed = true;
+            break;
+        }
+        t->invalid = true;
+        return;
+    }
+    t->end = pointer - content;
+}
+
+/* whether the calling thread stopped taking tapes, polled by the workers */
+static bool parallel_cancelled(parallel_job *const job) {
+    bool cancelled;
+
+    PyThread_acquire_lock(job->cancel_lock, WAIT_LOCK);
+    cancelled = job->cancelled;
+    PyThread_release_lock(job->cancel_lock);
+    return cancelled;
+}
+
+/* scan the chunks of a worker onto the tapes of their slots, as the calling thread empties them */
+static void parallel_scan_chunks(parallel_job *const job, Py_ssize_t worker) {
+    Py_ssize_t index;
+
+    for (index = worker; index < job->chunks; index += job->threads) {
+        parallel_slot *const slot = &job->slots[index % (2 * job->threads)];
+        /* wait until the previous tape of the slot has been materialized */
+        while (PyThread_acquire_lock_timed(slot->empty, 10000, 0) != PY_LOCK_ACQUIRED) {
+            if (parallel_cancelled(job)) {
+                return;
+            }
+        }
+        if (parallel_cancelled(job)) {
+            return;
+        }
+        job->scan(&slot->tape, job, index);
+        PyThread_release_lock(slot->filled);
+    }
+}
+
+static void parallel_thread_main(void *arg) {
+    parallel_worker *const worker = (parallel_worker *) arg;
+
+    worker->run(worker->job, worker->index);
+    PyThread_release_lock(worker->finished);
+}
+
+/* start job->threads threads running run */
+static bool parallel_start_threads(parallel_job *const job, void (*run)(parallel_job *job, Py_ssize_t index)) {
+    job->workers = (parallel_worker *) PyMem_Calloc((size_t) job->threads, sizeof(parallel_worker));
+    if (job->workers == NULL) {
+        PyErr_NoMemory();
+        return false;
+    }
+    for (job->started = 0; job->started < job->threads; job->started++) {
+        parallel_worker *const worker = &job->workers[job->started];
+        worker->job = job;
+        worker->index = job->started;
+        worker->run = run;
+        worker->finished = PyThread_allocate_lock();
+        if (worker->finished == NULL) {
+            PyErr_NoMemory();
+            return false;
+        }
+        PyThread_acquire_lock(worker->finished, WAIT_LOCK);
+        if (PyThread_start_new_thread(parallel_thread_main, worker) == PYTHREAD_INVALID_THREAD_ID) {
+            PyThread_free_lock(worker->finished);
+            PyErr_SetString(PyExc_RuntimeError, "Failed to parse JSON: can't start new thread");
+            return false;
+        }
+    }
+    return true;
+}
+
+/* wait for the threads that were started, before their job goes away */
+static void parallel_join_threads(parallel_job *const job) {
+    Py_ssize_t i;
+
+    for (i = 0; i < job->started; i++) {
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(job->workers[i].finished, WAIT_LOCK);
+        Py_END_ALLOW_THREADS
+        PyThread_free_lock(job->workers[i].finished);
+    }
+    job->started = 0;
+    PyMem_Free(job->workers);
+    job->workers = NULL;
+}
+
+/* run run on every thread of job, or on the calling thread without the GIL if there is one */
+static bool parallel_run(parallel_job *const job, void (*run)(parallel_job *job, Py_ssize_t index)) {
+    bool result = true;
+
+    if (job->threads <= 1) {
+        Py_BEGIN_ALLOW_THREADS
+        run(job, 0);
+        Py_END_ALLOW_THREADS
+        return true;
+    }
+    result = parallel_start_threads(job, run);
+    parallel_join_threads(job);
+    return result;
+}
+
+/* start scanning the chunks onto tapes, with one thread there is none and each chunk is scanned when it is taken */
+static bool parallel_pipeline_start(parallel_job *const job) {
+    Py_ssize_t i;
+
+    job->slots = (parallel_slot *) PyMem_Calloc((size_t) (2 * job->threads), sizeof(parallel_slot));
+    if (job->slots == NULL) {
+        PyErr_NoMemory();
+        return false;
+    }
+    if (job->threads <= 1) {
+        return true;
+    }
+    job->cancel_lock = PyThread_allocate_lock();
+    if (job->cancel_lock == NULL) {
+        PyErr_NoMemory();
+        return false;
+    }
+    for (i = 0; i < 2 * job->threads; i++) {
+        job->slots[i].filled = PyThread_allocate_lock();
+        job->slots[i].empty = PyThread_allocate_lock();
+        if ((job->slots[i].filled == NULL) || (job->slots[i].empty == NULL)) {
+            PyErr_NoMemory();
+            return false;
+        }
+        PyThread_acquire_lock(job->slots[i].filled, WAIT_LOCK);
+    }
+    return parallel_start_threads(job, parallel_scan_chunks);
+}
+
+/* wait for the tape of chunk index, the chunks are taken in order */
+static tape *parallel_pipeline_next(parallel_job *const job, Py_ssize_t index) {
+    parallel_slot *const slot = &job->slots[index % (2 * job->threads)];
+
+    Py_BEGIN_ALLOW_THREADS
+    if (job->threads <= 1) {
+        job->scan(&slot->tape, job, index);
+    } else {
+        PyThread_acquire_lock(slot->filled, WAIT_LOCK);
+    }
+    Py_END_ALLOW_THREADS
+    if (slot->tape.failed) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    return &slot->tape;
+}
+
+/* hand the tape of chunk index back to its worker */
+static void parallel_pipeline_release(parallel_job *const job, Py_ssize_t index) {
+    if (job->threads > 1) {
+        PyThread_release_lock(job->slots[index % (2 * job->threads)].empty);
+    }
+}
+
+/* stop the workers and wait for them before their tapes and the input go away */
+static void parallel_pipeline_finish(parallel_job *const job) {
+    Py_ssize_t i;
+
+    if (job->cancel_lock != NULL) {
+        PyThread_acquire_lock(job->cancel_lock, WAIT_LOCK);
+        job->cancelled = true;
+        PyThread_release_lock(job->cancel_lock);
+    }
+    parallel_join_threads(job);
+    if (job->cancel_lock != NULL) {
+        PyThread_free_lock(job->cancel_lock);
+        job->cancel_lock = NULL;
+    }
+    if (job->slots == NULL) {
+        return;
+    }
+    for (i = 0; i < 2 * job->threads; i++) {
+        PyMem_RawFree(job->slots[i].tape.entries);
+        PyMem_RawFree(job->slots[i].tape.containers);
+        if (job->slots[i].filled != NULL) {
+            PyThread_free_lock(job->slots[i].filled);
+        }
+        if (job->slots[i].empty != NULL) {
+            PyThread_free_lock(job->slots[i].empty);
+        }
+    }
+    PyMem_Free(job->slots);
+    job->slots = NULL;
+}
+
+/* create a string from its tape entry */
+static PyObject *tape_string(const tape_entry *const entry, const unsigned char *const content) {
+    const unsigned char *const input = content + entry->start;
+    PyObject *item = NULL;
+
+    if (entry->raw && (entry->maxchar < 0x80)) {
+        item = PyUnicode_New(entry->length, 127);
+        if (item != NULL) {
+            memcpy(PyUnicode_1BYTE_DATA(item), input, (size_t) entry->length);
+        }
+        return item;
+    }
+    item = PyUnicode_New(entry->value.output_length, entry->maxchar);
+    if (item != NULL) {
+        write_string_utf8(PyUnicode_KIND(item), PyUnicode_DATA(item), input, input + entry->length);
+    }
+    return item;
+}
+
+/* create an object key from its tape entry, through the key cache of buffer as parse_object_key does */
+static PyObject *tape_key(parse_buffer *const buffer, const tape_entry *const entry, const unsigned char *const content) {
+    const unsigned char *const raw = content + entry->start;
+    key_cache_entry *slot = NULL;
+    PyObject *key = NULL;
+    size_t hash = 2166136261u;
+    Py_ssize_t i;
+
+    if (!entry->raw || (entry->length > KEY_CACHE_MAX_KEY_LENGTH)) {
+        return tape_string(entry, content);
+    }
+    if (!ensure_key_cache(buffer)) {
+        return NULL;
+    }
+    /* FNV-1a */
+    for (i = 0; i < entry->length; i++) {
+        hash = (hash ^ raw[i]) * 16777619u;
+    }
+    slot = &buffer->key_cache[hash & (KEY_CACHE_SIZE - 1)];
+    if ((slot->key != NULL) && (slot->raw_length == entry->length) && (memcmp(slot->raw, raw, (size_t) entry->length) == 0)) {
+        Py_INCREF(slot->key);
+        return slot->key;
+    }
+    key = tape_string(entry, content);
+    if (key == NULL) {
+        return NULL;
+    }
+    Py_XDECREF(slot->key);
+    Py_INCREF(key);
+    slot->key = key;
+    slot->raw = raw;
+    slot->raw_length = entry->length;
+    return key;
+}
+
+/* Create the value whose entries start at index, which is left after them. The value is a line, or an element of the
+ * array open in buffer. Errors report the same positions as the parser, buffer->offset is set to them. */
+static PyObject *tape_document(parse_buffer *const buffer, const tape *const t, Py_ssize_t *index, const unsigned char *const content) {
+    const Py_ssize_t depth = buffer->depth;
+    const Py_ssize_t stack_top = buffer->value_stack_top;
+    Py_ssize_t i = *index;
+    PyObject *value = NULL;
+
+    buffer->origin = 0;
+    for (;;) {
+        const tape_entry *const entry = &t->entries[i++];
+
+        switch ((tape_type) entry->type) {
+            case TAPE_ARRAY:
+            case TAPE_OBJECT:
+                buffer->offset = entry->start;
+                if (!open_container(buffer, entry->type == TAPE_OBJECT)) {
+                    goto fail;
+                }
+                continue;
+            case TAPE_END:
+                buffer->offset = entry->start;
+                value = close_container(buffer);
+                break;
+            case TAPE_NULL:
+                Py_INCREF(Py_None);
+                value = Py_None;
+                break;
+            case TAPE_TRUE:
+                Py_INCREF(Py_True);
+                value = Py_True;
+                break;
+            case TAPE_FALSE:
+                Py_INCREF(Py_False);
+                value = Py_False;
+                break;
+            case TAPE_INFINITY:
+                value = PyFloat_FromDouble(INFINITY);
+                break;
+            case TAPE_NEGATIVE_INFINITY:
+                value = PyFloat_FromDouble(-INFINITY);
+                break;
+            case TAPE_NAN:
+                value = PyFloat_FromDouble(Py_NAN);
+                break;
+            case TAPE_INTEGER:
+                value = PyLong_FromLongLong(entry->value.integer);
+                break;
+            case TAPE_FLOAT:
+                value = PyFloat_FromDouble(entry->value.number);
+                break;
+            case TAPE_NUMBER:
+                buffer->offset = entry->start;
+                if (!parse_number_ascii(&value, buffer, content + entry->start, content + entry->start + entry->length)) {
+                    value = NULL;
+                }
+                break;
+            case TAPE_STRING:
+                value = tape_string(entry, content);
+                break;
+            case TAPE_KEY:
+                value = tape_key(buffer, entry, content);
+                break;
+            default:
+                /* lines only start documents */
+                PyErr_SetString(PyExc_SystemError, "Failed to parse JSON: invalid tape");
+                goto fail;
+        }
+        if (value == NULL) {
+            goto fail;
+        }
+        if (buffer->depth == depth) {
+            *index = i;
+            return value;
+        }
+        if (!push_value(buffer, value)) {
+            value = NULL;
+            goto fail;
+        }
+        value = NULL;
+    }
+
+fail:
+    pop_values(buffer, stack_top);
+    buffer->depth = depth;
+    /* skip the rest of the line */
+    while ((i < t->size) && (t->entries[i].type != TAPE_LINE) && (t->entries[i].type != TAPE_INVALID_LINE)) {
+        i++;
+    }
+    *index = i;
+    return NULL;
+}
+
+/* create the documents of the lines on a tape and append them to list, handling invalid lines as errors says */
+static bool tape_materialize(parse_buffer *const buffer, const tape *const t, const unsigned char *const content, Py_ssize_t first_lineno, line_errors errors, PyObject *list) {
+    Py_ssize_t i = 0;
+
+    while (i < t->size) {
+        const tape_entry *const line = &t->entries[i++];
+        const Py_ssize_t lineno = first_lineno + line->value.lineno;
+        PyObject *item = NULL;
+
+        if (line->type == TAPE_INVALID_LINE) {
+            /* the parser reports why */
+            buffer->origin = line->start;
+            item = parse_line_utf8(buffer, content + line->start, line->length);
+        } else {
+            item = tape_document(buffer, t, &i, content);
+        }
+        if (item == NULL) {
+            if (PyErr_Occurred() && !handle_line_error(errors, lineno, &item)) {
+                return false;
+            }
+            if (item == NULL) {
+                continue; /* a skipped line */
+            }
+        }
+        if (PyList_Append(list, item) < 0) {
+            Py_DECREF(item);
+            return false;
+        }
+        Py_DECREF(item);
+    }
+    return true;
+}
+
+/* the number of processors, for threads=0 */
+static Py_ssize_t processor_count(void) {
+#ifdef __WINDOWS__
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (Py_ssize_t) info.dwNumberOfProcessors;
+#else
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (Py_ssize_t) count : 1;
+#endif
+}
+
+/* Parse the lines of content with the given number of worker threads, appending the documents to list. */
+static bool parse_lines_parallel(parse_buffer *const buffer, const unsigned char *const content, Py_ssize_t length, Py_ssize_t threads, line_errors errors, PyObject *list) {
+    parallel_job job = {content, length, buffer->max_depth, (length + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE, threads, tape_scan_lines, NULL, 0, NULL, NULL, 0, false, NULL};
+    Py_ssize_t lineno = 0;
+    Py_ssize_t index;
+    bool result = false;
+
+    if (job.threads > job.chunks) {
+        job.threads = job.chunks;
+    }
+    if (!parallel_pipeline_start(&job)) {
+        goto cleanup;
+    }
+    for (index = 0; index < job.chunks; index++) {
+        const tape *const t = parallel_pipeline_next(&job, index);
+        bool materialized;
+
+        if (t == NULL) {
+            goto cleanup;
+        }
+        materialized = tape_materialize(buffer, t, content, lineno, errors, list);
+        lineno += t->lines;
+        parallel_pipeline_release(&job, index);
+        if (!materialized) {
+            goto cleanup;
+        }
+    }
+    result = true;
+
+cleanup:
+    parallel_pipeline_finish(&job);
+    return result;
+}
+
+/* Parse a document that is a large array with the given number of worker threads. The array is cut into chunks, a
+ * prefix pass over their quotes and brackets tells what each chunk starts in, and the elements from the first comma
+ * in a chunk on are scanned in parallel. The elements are created in order, as long as the scanned ranges line up,
+ * and the parser takes over after the last of them: it closes the array, or reports the error where they stopped.
+ * The scratch memory of buffer is released. */
+static PyObject *parse_document_parallel(parse_buffer *const buffer, const unsigned char *const content, Py_ssize_t length, Py_ssize_t threads) {
+    parallel_job job = {content, length, buffer->max_depth - 1, (length + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE, threads, tape_scan_elements, NULL, 0, NULL, NULL, 0, false, NULL};
+    PyObject *item = NULL;
+    Py_ssize_t resume = -1; /* the comma or bracket after the last element created, -1 before the first */
+    Py_ssize_t expected = 0; /* where the next elements have to start */
+    bool in_string = false;
+    Py_ssize_t depth = 0;
+    Py_ssize_t index;
+
+    buffer->hooks = global_hooks;
+    buffer->content = content;
+    buffer->length = length;
+    buffer->offset = 0;
+    buffer->state = STATE_VALUE;
+    if (length > 0) {
+        skip_bom_utf8(buffer);
+        buffer_skip_whitespace_utf8(buffer);
+    }
+    if ((job.threads <= 1) || (job.chunks < 2) || (buffer->max_depth < 1) || (length == 0) || (content[buffer->offset] != '[')) {
+        return parse_document_utf8(buffer, content, length);
+    }
+    if (job.threads > job.chunks) {
+        job.threads = job.chunks;
+    }
+    if (!open_container(buffer, false)) {
+        goto fail;
+    }
+    buffer->offset++;
+    job.elements_start = buffer->offset;
+    expected = job.elements_start;
+
+    job.document = (document_chunk *) PyMem_Calloc((size_t) (job.chunks + 1), sizeof(document_chunk));
+    if (job.document == NULL) {
+        PyErr_NoMemory();
+        goto fail;
+    }
+    for (index = 1; index <= job.chunks; index++) {
+        Py_ssize_t start = (index < job.chunks) ? index * PARALLEL_CHUNK_SIZE : length;
+        while ((start < length) && (content[start - 1] == '\\')) {
+            start++;
+        }
+        job.document[index].start = (start > job.document[index - 1].start) ? start : job.document[index - 1].start;
+    }
+    if (!parallel_run(&job, document_count_chunks)) {
+        goto fail;
+    }
+    for (index = 0; index < job.chunks; index++) {
+        job.document[index].in_string = in_string;
+        job.document[index].depth = depth;
+        depth += job.document[index].depth_change[in_string];
+        in_string ^= job.document[index].quotes_odd;
+    }
+
+    if (!parallel_pipeline_start(&job)) {
+        goto fail;
+    }
+    for (index = 0; index < job.chunks; index++) {
+        const tape *const t = parallel_pipeline_next(&job, index);
+        Py_ssize_t i = 0;
+
+        if (t == NULL) {
+            goto fail;
+        }
+        if (t->start < 0) {
+            /* no elements start in the chunk */
+            parallel_pipeline_release(&job, index);
+            continue;
+        }
+        if (t->invalid || (t->start != expected)) {
+            break;
+        }
+        while (i < t->size) {
+            PyObject *element = tape_document(buffer, t, &i, content);
+            if ((element == NULL) || !push_value(buffer, element)) {
+                goto fail;
+            }
+        }
+        resume = t->end;
+        expected = t->end + 1;
+        parallel_pipeline_release(&job, index);
+        if (t->closed) {
+            break;
+        }
+    }
+    parallel_pipeline_finish(&job);
+
+    /* the parser goes on after the last element created */
+    if (resume < 0) {
+        buffer->offset = job.elements_start;
+        buffer_skip_whitespace_utf8(buffer);
+        buffer->state = STATE_ARRAY_START;
+    } else {
+        buffer->offset = resume;
+        buffer->state = STATE_NEXT;
+    }
+    item = finish_text_utf8(buffer);
+    PyMem_Free(job.document);
+    parse_buffer_free(buffer);
+    return item;
+
+fail:
+    parallel_pipeline_finish(&job);
+    PyMem_Free(job.document);
+    pop_values(buffer, 0);
+    buffer->depth = 0;
+    parse_buffer_free(buffer);
+    return NULL;
+}
+
+/* Parse a document of bytes, on threads threads if it is a large array (0 for one per processor). */
+static PyObject *parse_bytes_document(parse_buffer *const buffer, const unsigned char *const content, Py_ssize_t length, Py_ssize_t threads) {
+    if (threads == 0) {
+        threads = processor_count();
+    }
+    if (threads > 1) {
+        return parse_document_parallel(buffer, content, length, threads);
+    }
+    return parse_document_utf8(buffer, (const Py_UCS1 *) content, length);
+}
+
+/* Parse a str in the representation it is stored in, so that no UTF-8 copy is created and cached on it.
+ * Positions in error messages count characters. ASCII is parsed as bytes, on threads threads if it is a large array. */
+static PyObject *parse_unicode_document(parse_buffer *const buffer, PyObject *unicode, Py_ssize_t threads) {
+    Py_ssize_t length;
+
+#if PY_VERSION_HEX < 0x030C0000
+    if (PyUnicode_READY(unicode) < 0) {
+        parse_buffer_free(buffer);
+        return NULL;
+    }
+#endif
+    length = PyUnicode_GET_LENGTH(unicode);
+    if (PyUnicode_IS_ASCII(unicode)) {
+        /* ASCII is valid UTF-8 */
+        return parse_bytes_document(buffer, (const unsigned char *) PyUnicode_DATA(unicode), length, threads);
+    }
+    switch (PyUnicode_KIND(unicode)) {
+        case PyUnicode_1BYTE_KIND:
+            return parse_document_ucs1(buffer, PyUnicode_1BYTE_DATA(unicode), length);
+        case PyUnicode_2BYTE_KIND:
+            return parse_document_ucs2(buffer, PyUnicode_2BYTE_DATA(unicode), length);
+        default:
+            return parse_document_ucs4(buffer, PyUnicode_4BYTE_DATA(unicode), length);
+    }
+}
+
+
+/* Map the regular file behind fd read-only. Returns false if fd is not a regular file, cannot be mapped or reports
+ * a size of 0: procfs and sysfs files do, whatever they hold, so they are read instead. */
+static bool map_file(int fd, const char **data, Py_ssize_t *size, void **handle) {
+#ifdef __WINDOWS__
+    HANDLE file = (HANDLE) _get_osfhandle(fd);
+    LARGE_INTEGER file_size;
+    HANDLE mapping = NULL;
+
+    if ((file == INVALID_HANDLE_VALUE) || (GetFileType(file) != FILE_TYPE_DISK) || !GetFileSizeEx(file, &file_size)) {
+        return false;
+    }
+    *data = NULL;
+    *size = (Py_ssize_t) file_size.QuadPart;
+    *handle = NULL;
+    if (*size == 0) {
+        return false;
+    }
+    mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        return false;
+    }
+    *data = (const char *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (*data == NULL) {
+        CloseHandle(mapping);
+        return false;
+    }
+    *handle = mapping;
+    return true;
+#else
+    struct stat file_stat;
+    void *map = NULL;
+
+    if ((fstat(fd, &file_stat) != 0) || !S_ISREG(file_stat.st_mode)) {
+        return false;
+    }
+    *data = NULL;
+    *size = (Py_ssize_t) file_stat.st_size;
+    *handle = NULL;
+    if (*size == 0) {
+        return false;
+    }
+    map = mmap(NULL, (size_t) *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(map, (size_t) *size, MADV_SEQUENTIAL);
+#endif
+    *data = (const char *) map;
+    return true;
+#endif
+}
+
+static void unmap_file(const char *data, Py_ssize_t size, void *handle) {
+    if (data == NULL) {
+        return;
+    }
+#ifdef __WINDOWS__
+    UnmapViewOfFile(data);
+    CloseHandle((HANDLE) handle);
+#else
+    munmap((void *) data, (size_t) size);
+#endif
+}
+
+/* The buffer read_fd reads into, kept for the next call so that reading pipes does not allocate every time.
+ * Only touched with the GIL held, a read_fd that finds it in use (an object_hook loading another descriptor,
+ * or another thread while this one waits for its read) allocates a buffer of its own. */
+static char *read_buffer = NULL;
+static Py_ssize_t read_buffer_capacity = 0;
+static bool read_buffer_in_use = false;
+
+/* give back the data of read_fd, the shared buffer is kept unless it grew too large to hold on to */
+static void release_read(char *data) {
+    if ((data == NULL) || (data != read_buffer)) {
+        PyMem_Free(data);
+        return;
+    }
+    read_buffer_in_use = false;
+    if (read_buffer_capacity > READ_BUFFER_KEEP_SIZE) {
+        PyMem_Free(read_buffer);
+        read_buffer = NULL;
+        read_buffer_capacity = 0;
+    }
+}
+
+/* Read everything from the current position of fd to its end into a buffer that grows as needed,
+ * data has to be given back with release_read. */
+static bool read_fd(int fd, char **data, Py_ssize_t *size) {
+    const bool shared = !read_buffer_in_use;
+    char *buffer = shared ? read_buffer : NULL;
+    Py_ssize_t capacity = shared ? read_buffer_capacity : 0;
+
+    read_buffer_in_use = true;
+    *size = 0;
+    for (;;) {
+        Py_ssize_t read_size;
+        if (capacity - *size < READ_CHUNK_SIZE) {
+            char *new_buffer = (char *) PyMem_Realloc(buffer, (size_t) (capacity + ((capacity < READ_CHUNK_SIZE) ? READ_CHUNK_SIZE : capacity)));
+            if (new_buffer == NULL) {
+                PyErr_NoMemory();
+                goto fail;
+            }
+            buffer = new_buffer;
+            capacity += (capacity < READ_CHUNK_SIZE) ? READ_CHUNK_SIZE : capacity;
+            if (shared) {
+                read_buffer = buffer;
+                read_buffer_capacity = capacity;
+            }
+        }
+        Py_BEGIN_ALLOW_THREADS
+#ifdef __WINDOWS__
+        read_size = (Py_ssize_t) _read(fd, buffer + *size, (unsigned int) (((capacity - *size) > INT_MAX) ? INT_MAX : (capacity - *size)));
+#else
+        read_size = (Py_ssize_t) read(fd, buffer + *size, (size_t) (capacity - *size));
+#endif
+        Py_END_ALLOW_THREADS
+        if (read_size < 0) {
+            if ((errno == EINTR) && (PyErr_CheckSignals() == 0)) {
+                continue;
+            }
+            if (!PyErr_Occurred()) {
+                PyErr_SetFromErrno(PyExc_OSError);
+            }
+            goto fail;
+        }
+        if (read_size == 0) {
+            break;
+        }
+        *size += read_size;
+    }
+
+    *data = buffer;
+    return true;
+
+fail:
+    if (shared && (buffer == NULL)) {
+        read_buffer_in_use = false;
+    }
+    release_read(buffer);
+    return false;
+}
+
+/* Parse everything from the current position of fd to its end. Regular files are mapped and parsed in place,
+ * anything else (pipes, sockets, ...) is read into a buffer first. */
+static PyObject *parse_fd(parse_buffer *const buffer, int fd, Py_ssize_t threads) {
+    PyObject *item = NULL;
+    const char *map = NULL;
+    Py_ssize_t map_size = 0;
+    void *map_handle = NULL;
+    char *data = NULL;
+    Py_ssize_t size = 0;
+
+    if (map_file(fd, &map, &map_size, &map_handle)) {
+#ifdef __WINDOWS__
+        Py_ssize_t position = (Py_ssize_t) _lseeki64(fd, 0, SEEK_CUR);
+#else
+        Py_ssize_t position = (Py_ssize_t) lseek(fd, 0, SEEK_CUR);
+#endif
+        if ((position < 0) || (position > map_size)) {
+            position = (position < 0) ? 0 : map_size;
+        }
+        item = parse_bytes_document(buffer, (const unsigned char *) map + position, map_size - position, threads);
+        unmap_file(map, map_size, map_handle);
+        /* leave fd at the end, as reading it would have */
+#ifdef __WINDOWS__
+        _lseeki64(fd, map_size, SEEK_SET);
+#else
+        lseek(fd, (off_t) map_size, SEEK_SET);
+#endif
+        return item;
+    }
+
+    if (!read_fd(fd, &data, &size)) {
+        parse_buffer_free(buffer);
+        return NULL;
+    }
+    item = parse_bytes_document(buffer, (const unsigned char *) data, size, threads);
+    release_read(data);
+    return item;
+}
+
+/* open the file at path for reading, returns -1 with the error set if that fails */
+static int open_path(PyObject *path) {
+    int fd = -1;
+
+#ifdef __WINDOWS__
+    {
+        wchar_t *wide_path = PyUnicode_AsWideCharString(path, NULL);
+        if (wide_path == NULL) {
+            return -1;
+        }
+        Py_BEGIN_ALLOW_THREADS
+        fd = _wopen(wide_path, _O_RDONLY | _O_BINARY | _O_NOINHERIT);
+        Py_END_ALLOW_THREADS
+        PyMem_Free(wide_path);
+    }
+#else
+    {
+        PyObject *encoded_path = PyUnicode_EncodeFSDefault(path);
+        if (encoded_path == NULL) {
+            return -1;
+        }
+        Py_BEGIN_ALLOW_THREADS
+        fd = open(PyBytes_AS_STRING(encoded_path), O_RDONLY | O_CLOEXEC);
+        Py_END_ALLOW_THREADS
+        Py_DECREF(encoded_path);
+    }
+#endif
+    if (fd < 0) {
+        PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, path);
+    }
+    return fd;
+}
+
+static void close_fd(int fd) {
+#ifdef __WINDOWS__
+    _close(fd);
+#else
+    close(fd);
+#endif
+}
+
+
+/* validate the keyword arguments stored in buffer */
+static bool check_options(const parse_buffer *const buffer) {
+    if (buffer->object_hook && !PyCallable_Check(buffer->object_hook)) {
+        PyErr_Format(PyExc_TypeError, "Failed to parse JSON: object_hook is not callable");
+        return false;
+    }
+    if (buffer->max_depth < 0) {
+        PyErr_Format(PyExc_ValueError, "Failed to parse JSON: max_depth must not be negative");
+        return false;
+    }
+    return true;
+}
+
+/* validate the threads keyword argument */
+static bool check_threads(Py_ssize_t threads) {
+    if (threads < 0) {
+        PyErr_Format(PyExc_ValueError, "Failed to parse JSON: threads must not be negative");
+        return false;
+    }
+    return true;
+}
+
+/* Copy an include or exclude dict, so that nothing the parser calls can change it while it is used. Nested dicts
+ * project the value of their key, any other value becomes True or False. */
+static PyObject *copy_projection(PyObject *projection, Py_ssize_t depth) {
+    PyObject *copy = NULL;
+    PyObject *key = NULL;
+    PyObject *value = NULL;
+    Py_ssize_t position = 0;
+
+    if (!PyDict_Check(projection)) {
+        PyErr_Format(PyExc_TypeError, "Failed to parse JSON: include and exclude must be dicts, not %.200s", Py_TYPE(projection)->tp_name);
+        return NULL;
+    }
+    if (depth > CJSON_NESTING_LIMIT) {
+        PyErr_Format(PyExc_ValueError, "Failed to parse JSON: include or exclude is too deeply nested");
+        return NULL;
+    }
+    copy = PyDict_New();
+    if (copy == NULL) {
+        return NULL;
+    }
+    while (PyDict_Next(projection, &position, &key, &value)) {
+        PyObject *entry = NULL;
+
+        if (PyDict_Check(value)) {
+            entry = copy_projection(value, depth + 1);
+        } else {
+            const int selected = PyObject_IsTrue(value);
+            if (selected >= 0) {
+                entry = selected ? Py_True : Py_False;
+                Py_INCREF(entry);
+            }
+        }
+        if ((entry == NULL) || (PyDict_SetItem(copy, key, entry) < 0)) {
+            Py_XDECREF(entry);
+            Py_DECREF(copy);
+            return NULL;
+        }
+        Py_DECREF(entry);
+    }
+    return copy;
+}
+
+/* convert the include and exclude keyword arguments into the projection of buffer */
+static bool parse_projection_option(parse_buffer *const buffer, PyObject *include, PyObject *exclude) {
+    include = (include == Py_None) ? NULL : include;
+    exclude = (exclude == Py_None) ? NULL : exclude;
+    if ((include != NULL) && (exclude != NULL)) {
+        PyErr_Format(PyExc_ValueError, "Failed to parse JSON: include and exclude cannot be combined");
+        return false;
+    }
+    if ((include == NULL) && (exclude == NULL)) {
+        return true;
+    }
+    buffer->exclude = (exclude != NULL);
+    buffer->projection = copy_projection(buffer->exclude ? exclude : include, 0);
+    return buffer->projection != NULL;
+}
+
+PyObject *pycJSON_Decode(PyObject *self, PyObject *args, PyObject *kwargs) {
+    parse_buffer buffer = PARSE_BUFFER_INIT;
+    PyObject *item = NULL;
+    PyObject *arg = NULL;
+    PyObject *include = NULL;
+    PyObject *exclude = NULL;
+    Py_buffer view = {0};
+    Py_ssize_t threads = 1;
+    char *copy = NULL;
+
+    const char *value = NULL;
+    Py_ssize_t buffer_length;
+    static const char *kwlist[] = {"s", "object_hook", "max_depth", "threads", "include", "exclude", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|OnnOO", (char **) kwlist, &arg, &buffer.object_hook, &buffer.max_depth, &threads, &include, &exclude)) {
+        PyErr_Format(PyExc_TypeError, "Failed to parse JSON: invalid argument, expected str / bytes-like object");
+        goto fail;
+    }
+    if (!parse_projection_option(&buffer, include, exclude)) {
+        goto fail;
+    }
+    if (buffer.projection != NULL) {
+        /* the parallel paths create whole elements, a projection is applied by the parser */
+        threads = 1;
+    }
+
+    /* str is parsed in its own representation, anything else through the buffer protocol, both without a copy */
+    if (PyUnicode_Check(arg)) {
+        if (!check_options(&buffer) || !check_threads(threads)) {
+            goto fail;
+        }
+        item = parse_unicode_document(&buffer, arg, threads);
+        Py_XDECREF(buffer.projection);
+        return item;
+    } else if (PyObject_CheckBuffer(arg)) {
+        if (PyObject_GetBuffer(arg, &view, PyBUF_SIMPLE) < 0) {
+            goto fail;
+        }
+        value = (const char *) view.buf;
+        buffer_length = view.len;
+    } else {
+        PyErr_Format(PyExc_TypeError, "Failed to parse JSON: invalid argument, expected str / bytes-like object");
+        goto fail;
+    }
+
+    if (!check_options(&buffer) || !check_threads(threads)) {
+        goto fail;
+    }
+    if ((threads != 1) && !PyBytes_Check(arg)) {
+        /* the workers scan ahead while object_hook runs, which could change a mutable buffer under them */
+        copy = (char *) PyMem_Malloc((buffer_length > 0) ? (size_t) buffer_length : 1);
+        if (copy == NULL) {
+            PyErr_NoMemory();
+            goto fail;
+        }
+        memcpy(copy, value, (size_t) buffer_length);
+        value = copy;
+    }
+
+    item = parse_bytes_document(&buffer, (const unsigned char *) value, buffer_length, threads);
+    PyMem_Free(copy);
+    PyBuffer_Release(&view);
+    Py_XDECREF(buffer.projection);
+    return item;
+
+fail:
+    PyBuffer_Release(&view);
+    Py_XDECREF(buffer.projection);
+    return NULL;
+}
+
+PyObject *pycJSON_DecodeFile(PyObject *self, PyObject *args, PyObject *kwargs) {
+    parse_buffer buffer = PARSE_BUFFER_INIT;
+    PyObject *item = NULL;
+    PyObject *file_obj = NULL;
+    PyObject *read_method = NULL;
+    PyObject *file_contents = NULL;
+    const char *value = NULL;
+    Py_ssize_t buffer_length;
+    Py_ssize_t threads = 1;
+    static const char *kwlist[] = {"fp", "object_hook", "max_depth", "threads", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|Onn", (char **) kwlist, &file_obj, &buffer.object_hook, &buffer.max_depth, &threads)) {
+        PyErr_Format(PyExc_TypeError, "Failed to parse JSON: invalid argument, expected str / bytes-like object");
+        goto fail;
+    }
+
+    if (!PyObject_HasAttrString(file_obj, "read")) {
+        PyErr_SetString(PyExc_TypeError, "object must have a 'read' method");
+        goto fail;
+    }
+
+    read_method = PyObject_GetAttrString(file_obj, "read");
+    if (!PyCallable_Check(read_method)) {
+        PyErr_SetString(PyExc_TypeError, "'read' method is not callable");
+        goto fail;
+    }
+
+    file_contents = PyObject_CallObject(read_method, NULL);
+    if (file_contents == NULL) {
+        PyErr_SetString(PyExc_ValueError, "Failed to read file contents");
+        goto fail;
+    }
+
+    // set value and buffer_length
+    if (PyUnicode_Check(file_contents)) {
+        value = NULL;
+        buffer_length = PyUnicode_GET_LENGTH(file_contents);
+    } else if (PyBytes_Check(file_contents)) {
+        value = PyBytes_AsString(file_contents);
+        if (value == NULL) {
+            PyErr_SetString(PyExc_ValueError, "Failed to parse JSON: value is NULL");
+            goto fail;
+        }
+        buffer_length = PyBytes_Size(file_contents);
+    } else {
+        PyErr_SetString(PyExc_ValueError, "file content must be a string");
+        goto fail;
+    }
+
+    if (!check_options(&buffer) || !check_threads(threads)) {
+        goto fail;
+    }
+
+    if (value == NULL) {
+        item = parse_unicode_document(&buffer, file_contents, threads);
+    } else {
+        item = parse_bytes_document(&buffer, (const unsigned char *) value, buffer_length, threads);
+    }
+    Py_XDECREF(file_contents);
+    Py_XDECREF(read_method);
+
+    return item;
+
+fail:
+    Py_XDECREF(file_contents);
+    Py_XDECREF(read_method);
+
+    return NULL;
+}
+
+PyObject *pycJSON_DecodePath(PyObject *self, PyObject *args, PyObject *kwargs) {
+    parse_buffer buffer = PARSE_BUFFER_INIT;
+    PyObject *item = NULL;
+    PyObject *path = NULL;
+    int fd = -1;
+    Py_ssize_t threads = 1;
+    static const char *kwlist[] = {"path", "object_hook", "max_depth", "threads", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&|Onn", (char **) kwlist, PyUnicode_FSDecoder, &path, &buffer.object_hook, &buffer.max_depth, &threads)) {
+        return NULL;
+    }
+
+    if (!check_options(&buffer) || !check_threads(threads)) {
+        goto fail;
+    }
+
+    fd = open_path(path);
+    if (fd < 0) {
+        goto fail;
+    }
+
+    item = parse_fd(&buffer, fd, threads);
+    close_fd(fd);
+    Py_DECREF(path);
+    return item;
+
+fail:
+    Py_DECREF(path);
+    return NULL;
+}
+
+PyObject *pycJSON_DecodeFd(PyObject *self, PyObject *args, PyObject *kwargs) {
+    parse_buffer buffer = PARSE_BUFFER_INIT;
+    int fd = -1;
+    Py_ssize_t threads = 1;
+    static const char *kwlist[] = {"fd", "object_hook", "max_depth", "threads", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "i|Onn", (char **) kwlist, &fd, &buffer.object_hook, &buffer.max_depth, &threads)) {
+        return NULL;
+    }
+
+    if (!check_options(&buffer) || !check_threads(threads)) {
+        return NULL;
+    }
+    if (fd < 0) {
+        PyErr_SetString(PyExc_ValueError, "Failed to parse JSON: fd must not be negative");
+        return NULL;
+    }
+
+    return parse_fd(&buffer, fd, threads);
+}
+
+PyObject *pycJSON_RawDecode(PyObject *self, PyObject *args, PyObject *kwargs) {
+    parse_buffer buffer = PARSE_BUFFER_INIT;
+    PyObject *item = NULL;
+    PyObject *arg = NULL;
+    Py_buffer view = {0};
+    Py_ssize_t index = 0;
+    Py_ssize_t length = 0;
+    Py_ssize_t end = 0;
+    static const char *kwlist[] = {"s", "idx", "object_hook", "max_depth", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|nOn", (char **) kwlist, &arg, &index, &buffer.object_hook, &buffer.max_depth)) {
+        return NULL;
+    }
+
+    if (!check_options(&buffer)) {
+        return NULL;
+    }
+    /* str is parsed in its own representation and indexed by characters, anything else by bytes, both without a copy */
+    if (PyUnicode_Check(arg)) {
+#if PY_VERSION_HEX < 0x030C0000
+        if (PyUnicode_READY(arg) < 0) {
+            return NULL;
+        }
+#endif
+        length = PyUnicode_GET_LENGTH(arg);
+    } else if (PyObject_CheckBuffer(arg)) {
+        if (PyObject_GetBuffer(arg, &view, PyBUF_SIMPLE) < 0) {
+            return NULL;
+        }
+        length = view.len;
+    } else {
+        PyErr_Format(PyExc_TypeError, "Failed to parse JSON: invalid argument, expected str / bytes-like object");
+        return NULL;
+    }
+    if ((index < 0) || (index > length)) {
+        PyErr_Format(PyExc_ValueError, "Failed to parse JSON: idx out of range");
+        goto fail;
+    }
+
+    if (view.obj != NULL) {
+        item = parse_raw_utf8(&buffer, (const Py_UCS1 *) view.buf, length, index, &end);
+    } else if (PyUnicode_IS_ASCII(arg)) {
+        item = parse_raw_utf8(&buffer, (const Py_UCS1 *) PyUnicode_DATA(arg), length, index, &end);
+    } else if (PyUnicode_KIND(arg) == PyUnicode_1BYTE_KIND) {
+        item = parse_raw_ucs1(&buffer, PyUnicode_1BYTE_DATA(arg), length, index, &end);
+    } else if (PyUnicode_KIND(arg) == PyUnicode_2BYTE_KIND) {
+        item = parse_raw_ucs2(&buffer, PyUnicode_2BYTE_DATA(arg), length, index, &end);
+    } else {
+        item = parse_raw_ucs4(&buffer, PyUnicode_4BYTE_DATA(arg), length, index, &end);
+    }
+    PyBuffer_Release(&view);
+    if (item == NULL) {
+        return NULL;
+    }
+    return Py_BuildValue("(Nn)", item, end);
+
+fail:
+    PyBuffer_Release(&view);
+    return NULL;
+}
+
+/* convert the errors keyword argument of the JSON Lines functions */
+static bool parse_errors_option(const char *errors, line_errors *result) {
+    if (strcmp(errors, "raise") == 0) {
+        *result = LINE_ERRORS_RAISE;
+    } else if (strcmp(errors, "skip") == 0) {
+        *result = LINE_ERRORS_SKIP;
+    } else if (strcmp(errors, "collect") == 0) {
+        *result = LINE_ERRORS_COLLECT;
+    } else {
+        PyErr_Format(PyExc_ValueError, "Failed to parse JSON: errors must be 'raise', 'skip' or 'collect', not '%s'", errors);
+        return false;
+    }
+    return true;
+}
+
+PyObject *pycJSON_DecodeLines(PyObject *self, PyObject *args, PyObject *kwargs) {
+    parse_buffer buffer = PARSE_BUFFER_INIT;
+    PyObject *list = NULL;
+    PyObject *arg = NULL;
+    Py_buffer view = {0};
+    const char *errors_name = "raise";
+    line_errors errors = LINE_ERRORS_RAISE;
+    bool parsed = false;
+    static const char *kwlist[] = {"s", "object_hook", "max_depth", "errors", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|Ons", (char **) kwlist, &arg, &buffer.object_hook, &buffer.max_depth, &errors_name)) {
+        return NULL;
+    }
+    if (!check_options(&buffer) || !parse_errors_option(errors_name, &errors)) {
+        return NULL;
+    }
+
+    list = PyList_New(0);
+    if (list == NULL) {
+        return NULL;
+    }
+    buffer.hooks = global_hooks;
+    /* one parse_buffer for all lines, keys repeated by the records are created once */
+    if (PyUnicode_Check(arg)) {
+#if PY_VERSION_HEX < 0x030C0000
+        if (PyUnicode_READY(arg) < 0) {
+            goto fail;
+        }
+#endif
+        if (PyUnicode_IS_ASCII(arg)) {
+            parsed = parse_lines_utf8(&buffer, (const Py_UCS1 *) PyUnicode_DATA(arg), PyUnicode_GET_LENGTH(arg), errors, list);
+        } else if (PyUnicode_KIND(arg) == PyUnicode_1BYTE_KIND) {
+            parsed = parse_lines_ucs1(&buffer, PyUnicode_1BYTE_DATA(arg), PyUnicode_GET_LENGTH(arg), errors, list);
+        } else if (PyUnicode_KIND(arg) == PyUnicode_2BYTE_KIND) {
+            parsed = parse_lines_ucs2(&buffer, PyUnicode_2BYTE_DATA(arg), PyUnicode_GET_LENGTH(arg), errors, list);
+        } else {
+            parsed = parse_lines_ucs4(&buffer, PyUnicode_4BYTE_DATA(arg), PyUnicode_GET_LENGTH(arg), errors, list);
+        }
+    } else if (PyObject_CheckBuffer(arg)) {
+        if (PyObject_GetBuffer(arg, &view, PyBUF_SIMPLE) < 0) {
+            goto fail;
+        }
+        parsed = parse_lines_utf8(&buffer, (const Py_UCS1 *) view.buf, view.len, errors, list);
+        PyBuffer_Release(&view);
+    } else {
+        PyErr_Format(PyExc_TypeError, "Failed to parse JSON: invalid argument, expected str / bytes-like object");
+    }
+    if (!parsed) {
+        goto fail;
+    }
+    parse_buffer_free(&buffer);
+    return list;
+
+fail:
+    parse_buffer_free(&buffer);
+    Py_DECREF(list);
+    return NULL;
+}
+
+/* The iterator returned by iter_lines. The file is read in chunks, each line is parsed as soon as it is complete. */
+typedef struct
+{
+    PyObject_HEAD
+    parse_buffer buffer; /* shared by the lines, its key cache lives as long as the chunk the keys point into */
+    PyObject *read_method;
+    unsigned char *data; /* the lines that are not parsed yet */
+    Py_ssize_t size;
+    Py_ssize_t capacity;
+    Py_ssize_t offset; /* start of the next line in data */
+    Py_ssize_t searched; /* data before it has no newline after offset */
+    Py_ssize_t origin; /* position of data[0] in the file */
+    Py_ssize_t lineno;
+    line_errors errors;
+    bool eof;
+    bool parsing; /* an object_hook must not advance the iterator that called it */
+} LinesIteratorObject;
+
+/* append the next chunk of the file to data, dropping the lines parsed before */
+static bool lines_iterator_read(LinesIteratorObject *self) {
+    PyObject *chunk = NULL;
+    const char *value = NULL;
+    Py_ssize_t length = 0;
+
+    chunk = PyObject_CallFunction(self->read_method, "n", (Py_ssize_t) READ_CHUNK_SIZE);
+    if (chunk == NULL) {
+        return false;
+    }
+    /* str is read as UTF-8, positions in error messages count its bytes */
+    if (PyUnicode_Check(chunk)) {
+        value = PyUnicode_AsUTF8AndSize(chunk, &length);
+    } else if (PyBytes_Check(chunk)) {
+        value = PyBytes_AS_STRING(chunk);
+        length = PyBytes_GET_SIZE(chunk);
+    } else {
+        PyErr_SetString(PyExc_ValueError, "file content must be a string");
+    }
+    if (value == NULL) {
+        Py_DECREF(chunk);
+        return false;
+    }
+    if (length == 0) {
+        self->eof = true;
+        Py_DECREF(chunk);
+        return true;
+    }
+
+    /* the cached keys point into the lines that are moved now */
+    key_cache_clear(&self->buffer);
+    if (self->size > self->offset) {
+        /* data is still NULL before the first chunk */
+        memmove(self->data, self->data + self->offset, (size_t) (self->size - self->offset));
+    }
+    self->size -= self->offset;
+    self->searched -= self->offset;
+    self->origin += self->offset;
+    self->offset = 0;
+    if (self->capacity - self->size < length) {
+        Py_ssize_t new_capacity = (self->capacity < READ_CHUNK_SIZE) ? READ_CHUNK_SIZE : self->capacity;
+        unsigned char *new_data = NULL;
+        while (new_capacity - self->size < length) {
+            new_capacity *= 2;
+        }
+        new_data = (unsigned char *) PyMem_Realloc(self->data, (size_t) new_capacity);
+        if (new_data == NULL) {
+            Py_DECREF(chunk);
+            PyErr_NoMemory();
+            return false;
+        }
+        self->data = new_data;
+        self->capacity = new_capacity;
+    }
+    memcpy(self->data + self->size, value, (size_t) length);
+    self->size += length;
+    Py_DECREF(chunk);
+    return true;
+}
+
+static PyObject *LinesIterator_next(LinesIteratorObject *self) {
+    if (self->parsing) {
+        PyErr_SetString(PyExc_RuntimeError, "iter_lines is parsing");
+        return NULL;
+    }
+
+    for (;;) {
+        const unsigned char *newline = NULL;
+        Py_ssize_t end;
+        PyObject *item = NULL;
+
+        if (self->searched < self->offset) {
+            self->searched = self->offset;
+        }
+        if (self->searched < self->size) {
+            newline = (const unsigned char *) memchr(self->data + self->searched, '\n', (size_t) (self->size - self->searched));
+        }
+        if (newline == NULL) {
+            self->searched = self->size;
+            if (!self->eof) {
+                if (!lines_iterator_read(self)) {
+                    return NULL;
+                }
+                continue;
+            }
+            if (self->offset == self->size) {
+                return NULL; /* StopIteration */
+            }
+        }
+        end = (newline == NULL) ? self->size : (Py_ssize_t) (newline - self->data);
+
+        self->lineno++;
+        self->buffer.origin = self->origin + self->offset;
+        self->parsing = true;
+        item = parse_line_utf8(&self->buffer, self->data + self->offset, end - self->offset);
+        self->parsing = false;
+        self->offset = (newline == NULL) ? end : end + 1;
+        if (item == NULL) {
+            if (PyErr_Occurred() && !handle_line_error(self->errors, self->lineno, &item)) {
+                return NULL;
+            }
+            if (item == NULL) {
+                continue; /* a blank or skipped line */
+            }
+        }
+        return item;
+    }
+}
+
+static int LinesIterator_traverse(LinesIteratorObject *self, visitproc visit, void *arg) {
+    Py_VISIT(self->read_method);
+    Py_VISIT(self->buffer.object_hook);
+    return 0;
+}
+
+static int LinesIterator_clear(LinesIteratorObject *self) {
+    Py_CLEAR(self->read_method);
+    Py_CLEAR(self->buffer.object_hook);
+    return 0;
+}
+
+static void LinesIterator_dealloc(LinesIteratorObject *self) {
+    PyObject_GC_UnTrack(self);
+    LinesIterator_clear(self);
+    parse_buffer_free(&self->buffer);
+    PyMem_Free(self->data);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+PyTypeObject LinesIteratorType = {
+        PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "cjson.LinesIterator",
+        .tp_basicsize = sizeof(LinesIteratorObject),
+        .tp_dealloc = (destructor) LinesIterator_dealloc,
+        .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,
+        .tp_doc = "Iterates over the documents of a JSON Lines file.",
+        .tp_traverse = (traverseproc) LinesIterator_traverse,
+        .tp_clear = (inquiry) LinesIterator_clear,
+        .tp_iter = PyObject_SelfIter,
+        .tp_iternext = (iternextfunc) LinesIterator_next,
+};
+
+PyObject *pycJSON_DecodeLinesIter(PyObject *self, PyObject *args, PyObject *kwargs) {
+    LinesIteratorObject *iterator = NULL;
+    PyObject *file_obj = NULL;
+    PyObject *object_hook = NULL;
+    Py_ssize_t max_depth = CJSON_NESTING_LIMIT;
+    const char *errors_name = "raise";
+    static const char *kwlist[] = {"fp", "object_hook", "max_depth", "errors", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|Ons", (char **) kwlist, &file_obj, &object_hook, &max_depth, &errors_name)) {
+        return NULL;
+    }
+
+    iterator = PyObject_GC_New(LinesIteratorObject, &LinesIteratorType);
+    if (iterator == NULL) {
+        return NULL;
+    }
+    memset(&iterator->buffer, 0, sizeof(LinesIteratorObject) - offsetof(LinesIteratorObject, buffer));
+    iterator->buffer = (parse_buffer) PARSE_BUFFER_INIT;
+    iterator->buffer.hooks = global_hooks;
+    iterator->buffer.max_depth = max_depth;
+    Py_XINCREF(object_hook);
+    iterator->buffer.object_hook = object_hook;
+    PyObject_GC_Track(iterator);
+
+    if (!check_options(&iterator->buffer) || !parse_errors_option(errors_name, &iterator->errors)) {
+        goto fail;
+    }
+    iterator->read_method = PyObject_GetAttrString(file_obj, "read");
+    if (iterator->read_method == NULL) {
+        PyErr_Clear();
+        PyErr_SetString(PyExc_TypeError, "object must have a 'read' method");
+        goto fail;
+    }
+    if (!PyCallable_Check(iterator->read_method)) {
+        PyErr_SetString(PyExc_TypeError, "'read' method is not callable");
+        goto fail;
+    }
+    return (PyObject *) iterator;
+
+fail:
+    Py_DECREF(iterator);
+    return NULL;
+}
+
+PyObject *pycJSON_DecodeLinesParallel(PyObject *self, PyObject *args, PyObject *kwargs) {
+    parse_buffer buffer = PARSE_BUFFER_INIT;
+    PyObject *list = NULL;
+    PyObject *path = NULL;
+    Py_ssize_t threads = 0;
+    const char *errors_name = "raise";
+    line_errors errors = LINE_ERRORS_RAISE;
+    int fd = -1;
+    const char *map = NULL;
+    Py_ssize_t map_size = 0;
+    void *map_handle = NULL;
+    char *data = NULL;
+    Py_ssize_t size = 0;
+    bool parsed = false;
+    static const char *kwlist[] = {"path", "threads", "object_hook", "max_depth", "errors", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&|nOns", (char **) kwlist, PyUnicode_FSDecoder, &path, &threads, &buffer.object_hook, &buffer.max_depth, &errors_name)) {
+        return NULL;
+    }
+
+    if (!check_options(&buffer) || !check_threads(threads) || !parse_errors_option(errors_name, &errors)) {
+        goto fail;
+    }
+    if (threads == 0) {
+        threads = processor_count();
+    }
+
+    fd = open_path(path);
+    if (fd < 0) {
+        goto fail;
+    }
+    /* the tapes point into the input, so it is mapped or read as a whole */
+    if (map_file(fd, &map, &map_size, &map_handle)) {
+        data = (char *) map;
+        size = map_size;
+    } else if (!read_fd(fd, &data, &size)) {
+        close_fd(fd);
+        goto fail;
+    }
+    close_fd(fd);
+
+    list = PyList_New(0);
+    if (list != NULL) {
+        buffer.hooks = global_hooks;
+        parsed = parse_lines_parallel(&buffer, (const unsigned char *) data, size, threads, errors, list);
+    }
+    parse_buffer_free(&buffer);
+    if (map != NULL) {
+        unmap_file(map, map_size, map_handle);
+    } else {
+        release_read(data);
+    }
+    if (!parsed) {
+        Py_XDECREF(list);
+        goto fail;
+    }
+    Py_DECREF(path);
+    return list;
+
+fail:
+    Py_DECREF(path);
+    return NULL;
+}
+
+/* A decoder that is fed a document in chunks. The chunks are parsed as they arrive: only the input from the token
+ * that was cut off by the end of the last chunk is kept, the parsed values and open containers stay on the stacks of
+ * the parse_buffer in between. */
+typedef struct
+{
+    PyObject_HEAD
+    parse_buffer buffer;
+    unsigned char *data; /* the input that is not parsed yet, its first unit is at buffer.origin in the whole input */
+    Py_ssize_t size; /* in units of kind bytes, as is capacity */
+    Py_ssize_t capacity;
+    bool text; /* the document is fed as str, data holds its characters and positions count them */
+    int kind; /* 1 for bytes-like chunks kept as UTF-8, the widest PyUnicode kind of the str chunks otherwise */
+    PyObject *result; /* the document, once it is complete */
+    bool started; /* the byte order mark has been checked for */
+    bool parsing; /* an object_hook must not feed the decoder that called it */
+} IncrementalDecoderObject;
+
+/* drop the input and the values parsed from it, and start a new document */
+static void incremental_decoder_reset(IncrementalDecoderObject *self) {
+    parse_buffer *const buffer = &self->buffer;
+
+    Py_CLEAR(self->result);
+    pop_values(buffer, 0);
+    key_cache_clear(buffer);
+    buffer->depth = 0;
+    buffer->state = STATE_VALUE;
+    buffer->origin = 0;
+    buffer->scanned = 0;
+    self->size = 0;
+    self->text = false;
+    self->kind = PyUnicode_1BYTE_KIND;
+    self->started = false;
+}
+
+/* Skip the byte order mark if start, and parse the value at the offset with the parser of the representation of
+ * the data. */
+static bool incremental_decoder_parse_value(IncrementalDecoderObject *self, PyObject **item, bool start) {
+    parse_buffer *const buffer = &self->buffer;
+
+    if (!self->text) {
+        if (start) {
+            skip_bom_utf8(buffer);
+        }
+        buffer_skip_whitespace_utf8(buffer);
+        return parse_value_utf8(item, buffer);
+    }
+    switch (self->kind) {
+        case PyUnicode_1BYTE_KIND:
+            buffer_skip_whitespace_ucs1(buffer);
+            return parse_value_ucs1(item, buffer);
+        case PyUnicode_2BYTE_KIND:
+            if (start) {
+                skip_bom_ucs2(buffer);
+            }
+            buffer_skip_whitespace_ucs2(buffer);
+            return parse_value_ucs2(item, buffer);
+        default:
+            if (start) {
+                skip_bom_ucs4(buffer);
+            }
+            buffer_skip_whitespace_ucs4(buffer);
+            return parse_value_ucs4(item, buffer);
+    }
+}
+
+/* copy length characters of source_kind to target, which holds characters of a kind at least as wide */
+static void copy_characters(void *target, int target_kind, const void *source, int source_kind, Py_ssize_t length) {
+    Py_ssize_t i;
+
+    if (target_kind == source_kind) {
+        memcpy(target, source, (size_t) (length * source_kind));
+        return;
+    }
+    for (i = 0; i < length; i++) {
+        PyUnicode_WRITE(target_kind, target, i, PyUnicode_READ(source_kind, source, i));
+    }
+}
+
+/* Parse the input fed so far. Unless final, a token cut off by the end of the input is left for the next chunk.
+ * The decoder is reset if the input is invalid. */
+static bool incremental_decoder_parse(IncrementalDecoderObject *self, bool final) {
+    parse_buffer *const buffer = &self->buffer;
+    PyObject *item = NULL;
+    bool start = false;
+
+    buffer->content = self->data;
+    buffer->length = self->size;
+    buffer->offset = 0;
+    buffer->partial = !final;
+    if (self->result == NULL) {
+        if (!self->started) {
+            if (!final && !self->text && (self->size < 3)) {
+                /* skip_bom looks at the first 3 bytes */
+                return true;
+            }
+            if (self->size == 0) {
+                PyErr_SetString(PyExc_ValueError, "Empty string");
+                goto fail;
+            }
+            start = true;
+            self->started = true;
+        }
+        if (!incremental_decoder_parse_value(self, &item, start)) {
+            if (PyErr_Occurred()) {
+                goto fail;
+            }
+            goto consume;
+        }
+        self->result = item;
+    }
+    if (buffer->offset < buffer->length) {
+        PyErr_Format(PyExc_ValueError, "Failed to parse JSON: extra characters at the end\nend position: %zd", error_position(buffer));
+        goto fail;
+    }
+
+consume:
+    /* the cached keys point into the input that is moved now */
+    key_cache_clear(buffer);
+    memmove(self->data, self->data + buffer->offset * self->kind, (size_t) ((self->size - buffer->offset) * self->kind));
+    self->size -= buffer->offset;
+    buffer->origin += buffer->offset;
+    if (buffer->scanned > 0) {
+        buffer->scanned -= buffer->offset;
+    }
+    buffer->offset = 0;
+    return true;
+
+fail:
+    incremental_decoder_reset(self);
+    return false;
+}
+
+static PyObject *IncrementalDecoder_new(PyTypeObject *type, PyObject *args, PyObject *kwargs) {
+    IncrementalDecoderObject *self = (IncrementalDecoderObject *) type->tp_alloc(type, 0);
+    if (self == NULL) {
+        return NULL;
+    }
+    self->buffer = (parse_buffer) PARSE_BUFFER_INIT;
+    self->buffer.hooks = global_hooks;
+    self->kind = PyUnicode_1BYTE_KIND;
+    return (PyObject *) self;
+}
+
+static int IncrementalDecoder_init(IncrementalDecoderObject *self, PyObject *args, PyObject *kwargs) {
+    PyObject *object_hook = NULL;
+    Py_ssize_t max_depth = CJSON_NESTING_LIMIT;
+    static const char *kwlist[] = {"object_hook", "max_depth", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|On", (char **) kwlist, &object_hook, &max_depth)) {
+        return -1;
+    }
+    if (self->parsing) {
+        PyErr_SetString(PyExc_RuntimeError, "IncrementalDecoder is parsing");
+        return -1;
+    }
+
+    incremental_decoder_reset(self);
+    Py_XINCREF(object_hook);
+    Py_XSETREF(self->buffer.object_hook, object_hook);
+    self->buffer.max_depth = max_depth;
+    if (!check_options(&self->buffer)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int IncrementalDecoder_traverse(IncrementalDecoderObject *self, visitproc visit, void *arg) {
+    Py_ssize_t i;
+
+    Py_VISIT(self->buffer.object_hook);
+    Py_VISIT(self->result);
+    for (i = 0; i < self->buffer.value_stack_top; i++) {
+        Py_VISIT(self->buffer.value_stack[i]);
+    }
+    return 0;
+}
+
+static int IncrementalDecoder_clear(IncrementalDecoderObject *self) {
+    incremental_decoder_reset(self);
+    Py_CLEAR(self->buffer.object_hook);
+    return 0;
+}
+
+static void IncrementalDecoder_dealloc(IncrementalDecoderObject *self) {
+    PyObject_GC_UnTrack(self);
+    IncrementalDecoder_clear(self);
+    parse_buffer_free(&self->buffer);
+    PyMem_Free(self->data);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static PyObject *IncrementalDecoder_feed(IncrementalDecoderObject *self, PyObject *arg) {
+    Py_buffer view = {0};
+    const void *value = NULL;
+    Py_ssize_t length = 0;
+    bool text = false;
+    int kind = PyUnicode_1BYTE_KIND;
+    int new_kind;
+    bool parsed;
+
+    if (self->parsing) {
+        PyErr_SetString(PyExc_RuntimeError, "IncrementalDecoder is parsing");
+        return NULL;
+    }
+    /* str is kept in its own representation rather than as UTF-8, positions in error messages count its characters */
+    if (PyUnicode_Check(arg)) {
+#if PY_VERSION_HEX < 0x030C0000
+        if (PyUnicode_READY(arg) < 0) {
+            return NULL;
+        }
+#endif
+        text = true;
+        kind = PyUnicode_KIND(arg);
+        value = PyUnicode_DATA(arg);
+        length = PyUnicode_GET_LENGTH(arg);
+    } else if (PyObject_CheckBuffer(arg)) {
+        if (PyObject_GetBuffer(arg, &view, PyBUF_SIMPLE) < 0) {
+            return NULL;
+        }
+        value = view.buf;
+        length = view.len;
+    } else {
+        PyErr_Format(PyExc_TypeError, "Failed to parse JSON: invalid argument, expected str / bytes-like object");
+        return NULL;
+    }
+    if (length == 0) {
+        PyBuffer_Release(&view);
+        Py_RETURN_NONE;
+    }
+    if (!self->started && (self->size == 0)) {
+        /* the first chunk of a document decides what the positions count */
+        self->text = text;
+    } else if (text != self->text) {
+        PyBuffer_Release(&view);
+        PyErr_Format(PyExc_TypeError, "Failed to parse JSON: a document must be fed as str or as bytes-like objects, not both");
+        return NULL;
+    }
+
+    new_kind = (kind > self->kind) ? kind : self->kind;
+    if ((self->capacity - self->size < length) || (new_kind != self->kind)) {
+        Py_ssize_t new_capacity = (self->capacity < READ_CHUNK_SIZE) ? READ_CHUNK_SIZE : self->capacity;
+        unsigned char *new_data = NULL;
+        while (new_capacity - self->size < length) {
+            new_capacity *= 2;
+        }
+        if (new_kind == self->kind) {
+            new_data = (unsigned char *) PyMem_Realloc(self->data, (size_t) (new_capacity * new_kind));
+        } else {
+            /* a wider str chunk widens the characters kept so far */
+            new_data = (unsigned char *) PyMem_Malloc((size_t) (new_capacity * new_kind));
+            if (new_data != NULL) {
+                copy_characters(new_data, new_kind, self->data, self->kind, self->size);
+                PyMem_Free(self->data);
+            }
+        }
+        if (new_data == NULL) {
+            PyBuffer_Release(&view);
+            PyErr_NoMemory();
+            return NULL;
+        }
+        self->data = new_data;
+        self->capacity = new_capacity;
+        self->kind = new_kind;
+    }
+    copy_characters(self->data + self->size * self->kind, self->kind, value, kind, length);
+    self->size += length;
+    PyBuffer_Release(&view);
+
+    self->parsing = true;
+    parsed = incremental_decoder_parse(self, false);
+    self->parsing = false;
+    if (!parsed) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *IncrementalDecoder_close(IncrementalDecoderObject *self, PyObject *Py_UNUSED(ignored)) {
+    PyObject *item = NULL;
+    bool parsed;
+
+    if (self->parsing) {
+        PyErr_SetString(PyExc_RuntimeError, "IncrementalDecoder is parsing");
+        return NULL;
+    }
+    self->parsing = true;
+    parsed = incremental_decoder_parse(self, true);
+    self->parsing = false;
+    if (!parsed) {
+        return NULL;
+    }
+    item = self->result;
+    self->result = NULL;
+    incremental_decoder_reset(self);
+    return item;
+}
+
+static PyMethodDef IncrementalDecoder_methods[] = {
+        {"feed", (PyCFunction) IncrementalDecoder_feed, METH_O, "Parses the next chunk of the document, a str or bytes-like object."},
+        {"close", (PyCFunction) IncrementalDecoder_close, METH_NOARGS, "Parses the end of the document and returns it, the decoder starts a new document after it."},
+        {NULL, NULL, 0, NULL} /* Sentinel */
+};
+
+PyTypeObject IncrementalDecoderType = {
+        PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "cjson.IncrementalDecoder",
+        .tp_basicsize = sizeof(IncrementalDecoderObject),
+        .tp_dealloc = (destructor) IncrementalDecoder_dealloc,
+        .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,
+        .tp_doc = "Converts JSON fed in chunks to dict object structure, parsing every chunk as it arrives.",
+        .tp_traverse = (traverseproc) IncrementalDecoder_traverse,
+        .tp_clear = (inquiry) IncrementalDecoder_clear,
+        .tp_methods = IncrementalDecoder_methods,
+        .tp_init = (initproc) IncrementalDecoder_init,
+        .tp_new = IncrementalDecoder_new,
+};
+
+#define LAZY_INDEX_MEMBERS 16 /* objects with fewer members are searched for a key instead of indexed */
+
+/* The tape of a document parsed by lazy_loads, shared by its nodes. The input is scanned and validated once, values
+ * are only created from the tape when they are accessed. */
+typedef struct
+{
+    PyObject_HEAD
+    PyObject *source; /* the bytes or ASCII str scanned in place, or the UTF-8 of another str */
+    unsigned char *copy; /* the copy scanned instead of a mutable buffer, which could change under the tape */
+    const unsigned char *content;
+    Py_ssize_t length;
+    tape tape;
+    parse_buffer buffer; /* the key cache and scratch memory for the values created */
+    PyObject *key_indexes; /* dict from the entry of an object looked up to the entries of its values by key */
+} LazyDocumentObject;
+
+/* an array or object of a lazily parsed document */
+typedef struct
+{
+    PyObject_HEAD
+    LazyDocumentObject *document;
+    Py_ssize_t index; /* of its entry on the tape */
+} LazyNodeObject;
+
+/* iterates over the values of an array or the keys of an object */
+typedef struct
+{
+    PyObject_HEAD
+    LazyNodeObject *node;
+    Py_ssize_t index; /* of the entry of the next value or key */
+    Py_ssize_t remaining;
+} LazyIteratorObject;
+
+extern PyTypeObject LazyDocumentType;
+extern PyTypeObject LazyNodeType;
+extern PyTypeObject LazyIteratorType;
+
+static void LazyDocument_dealloc(LazyDocumentObject *self) {
+    PyMem_RawFree(self->tape.entries);
+    PyMem_RawFree(self->tape.containers);
+    parse_buffer_free(&self->buffer);
+    PyMem_Free(self->copy);
+    Py_XDECREF(self->key_indexes);
+    Py_XDECREF(self->source);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+PyTypeObject LazyDocumentType = {
+        PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "cjson.Document",
+        .tp_basicsize = sizeof(LazyDocumentObject),
+        .tp_dealloc = (destructor) LazyDocument_dealloc,
+        .tp_flags = Py_TPFLAGS_DEFAULT,
+        .tp_doc = "The scanned input of lazy_loads, shared by the nodes of a document.",
+};
+
+/* the entry after the value whose entry is at index */
+static inline Py_ssize_t lazy_next(const tape *const t, Py_ssize_t index) {
+    if ((t->entries[index].type == TAPE_ARRAY) || (t->entries[index].type == TAPE_OBJECT)) {
+        return index + t->entries[index].length + 1;
+    }
+    return index + 1;
+}
+
+/* the value whose entry is at index: a node for arrays and objects, anything else is created */
+static PyObject *lazy_value(LazyDocumentObject *const document, Py_ssize_t index) {
+    const tape_entry *const entry = &document->tape.entries[index];
+    LazyNodeObject *node = NULL;
+
+    if ((entry->type != TAPE_ARRAY) && (entry->type != TAPE_OBJECT)) {
+        return tape_document(&document->buffer, &document->tape, &index, document->content);
+    }
+    node = PyObject_New(LazyNodeObject, &LazyNodeType);
+    if (node == NULL) {
+        return NULL;
+    }
+    Py_INCREF(document);
+    node->document = document;
+    node->index = index;
+    return (PyObject *) node;
+}
+
+/* whether the key entry without escape sequences is key, compared in the representation of key so that
+ * nothing is created or cached on it */
+static bool lazy_key_equal(const tape_entry *const entry, const unsigned char *const content, PyObject *key) {
+    const unsigned char *input = content + entry->start;
+    const unsigned char *const input_end = input + entry->length;
+    const int kind = PyUnicode_KIND(key);
+    const void *const data = PyUnicode_DATA(key);
+    Py_ssize_t i = 0;
+
+    if ((entry->value.output_length != PyUnicode_GET_LENGTH(key)) || (entry->maxchar > PyUnicode_MAX_CHAR_VALUE(key))) {
+        return false;
+    }
+    if (PyUnicode_IS_ASCII(key)) {
+        return memcmp(input, data, (size_t) entry->length) == 0;
+    }
+    while (input < input_end) {
+        Py_UCS4 codepoint = *input;
+
+        if (codepoint < 0x80) {
+            input++;
+        } else {
+            input += decode_utf8_unchecked(input, &codepoint);
+        }
+        if (codepoint != PyUnicode_READ(kind, data, i++)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* the dict from the keys of the object at index to the entries of their values, built on the first lookup,
+ * a borrowed reference or NULL with an error set */
+static PyObject *lazy_key_index(LazyDocumentObject *const document, Py_ssize_t index) {
+    const tape *const t = &document->tape;
+    PyObject *node_index = NULL;
+    PyObject *key_index = NULL;
+    Py_ssize_t entry = index + 1;
+    Py_ssize_t i;
+
+    if (document->key_indexes == NULL) {
+        document->key_indexes = PyDict_New();
+        if (document->key_indexes == NULL) {
+            return NULL;
+        }
+    }
+    node_index = PyLong_FromSsize_t(index);
+    if (node_index == NULL) {
+        return NULL;
+    }
+    key_index = PyDict_GetItemWithError(document->key_indexes, node_index);
+    if ((key_index != NULL) || PyErr_Occurred()) {
+        Py_DECREF(node_index);
+        return key_index;
+    }
+
+    key_index = PyDict_New();
+    if (key_index == NULL) {
+        goto fail;
+    }
+    for (i = 0; i < t->entries[index].value.count; i++) {
+        Py_ssize_t key_entry = entry;
+        /* a later duplicate key replaces the entry of an earlier one, as in the dict loads creates */
+        PyObject *key = tape_document(&document->buffer, t, &key_entry, document->content);
+        PyObject *position = NULL;
+        int stored;
+
+        if (key == NULL) {
+            goto fail;
+        }
+        position = PyLong_FromSsize_t(entry + 1);
+        if (position == NULL) {
+            Py_DECREF(key);
+            goto fail;
+        }
+        stored = PyDict_SetItem(key_index, key, position);
+        Py_DECREF(key);
+        Py_DECREF(position);
+        if (stored < 0) {
+            goto fail;
+        }
+        entry = lazy_next(t, entry + 1);
+    }
+    if (PyDict_SetItem(document->key_indexes, node_index, key_index) < 0) {
+        goto fail;
+    }
+    Py_DECREF(node_index);
+    Py_DECREF(key_index);
+    return key_index;
+
+fail:
+    Py_DECREF(node_index);
+    Py_XDECREF(key_index);
+    return NULL;
+}
+
+/* Find the value of key in an object node. Returns its entry, -1 if there is none and -2 with an error set.
+ * The last of duplicate keys counts, as in the dict loads creates. Large objects are looked up in their key index,
+ * small ones are searched. */
+static Py_ssize_t lazy_find(const LazyNodeObject *const self, PyObject *key) {
+    const tape *const t = &self->document->tape;
+    const unsigned char *const content = self->document->content;
+    Py_ssize_t index = self->index + 1;
+    Py_ssize_t found = -1;
+    Py_ssize_t i;
+
+    if (!PyUnicode_Check(key)) {
+        return -1;
+    }
+    if (t->entries[self->index].value.count >= LAZY_INDEX_MEMBERS) {
+        PyObject *const key_index = lazy_key_index(self->document, self->index);
+        PyObject *position = NULL;
+
+        if (key_index == NULL) {
+            return -2;
+        }
+        position = PyDict_GetItemWithError(key_index, key);
+        if (position == NULL) {
+            return PyErr_Occurred() ? -2 : -1;
+        }
+        return PyLong_AsSsize_t(position);
+    }
+    for (i = 0; i < t->entries[self->index].value.count; i++) {
+        const tape_entry *const entry = &t->entries[index];
+
+        if (entry->raw) {
+            if (lazy_key_equal(entry, content, key)) {
+                found = index + 1;
+            }
+        } else {
+            PyObject *unescaped = tape_string(entry, content);
+            int equal;
+
+            if (unescaped == NULL) {
+                return -2;
+            }
+            equal = PyUnicode_Compare(unescaped, key) == 0;
+            Py_DECREF(unescaped);
+            if (equal) {
+                found = index + 1;
+            }
+        }
+        index = lazy_next(t, index + 1);
+    }
+    return found;
+}
+
+/* the entry of element position of an array node, which must be in range */
+static Py_ssize_t lazy_element(const LazyNodeObject *const self, Py_ssize_t position) {
+    Py_ssize_t index = self->index + 1;
+
+    while (position-- > 0) {
+        index = lazy_next(&self->document->tape, index);
+    }
+    return index;
+}
+
+static inline bool lazy_is_object(const LazyNodeObject *const self) {
+    return self->document->tape.entries[self->index].type == TAPE_OBJECT;
+}
+
+static void LazyNode_dealloc(LazyNodeObject *self) {
+    Py_DECREF(self->document);
+    PyObject_Free(self);
+}
+
+static Py_ssize_t LazyNode_length(LazyNodeObject *self) {
+    return self->document->tape.entries[self->index].value.count;
+}
+
+/* the entry of the value of an array node at an integer key, -1 if there is none and -2 with an error set */
+static Py_ssize_t lazy_position(LazyNodeObject *self, PyObject *key) {
+    const Py_ssize_t count = LazyNode_length(self);
+    Py_ssize_t position;
+
+    if (!PyIndex_Check(key)) {
+        PyErr_Format(PyExc_TypeError, "list indices must be integers, not %.200s", Py_TYPE(key)->tp_name);
+        return -2;
+    }
+    position = PyNumber_AsSsize_t(key, PyExc_IndexError);
+    if ((position == -1) && PyErr_Occurred()) {
+        return -2;
+    }
+    if (position < 0) {
+        position += count;
+    }
+    if ((position < 0) || (position >= count)) {
+        return -1;
+    }
+    return lazy_element(self, position);
+}
+
+static PyObject *LazyNode_subscript(LazyNodeObject *self, PyObject *key) {
+    Py_ssize_t index;
+
+    if (lazy_is_object(self)) {
+        index = lazy_find(self, key);
+        if (index == -1) {
+            PyObject *args = PyTuple_Pack(1, key);
+            if (args != NULL) {
+                PyErr_SetObject(PyExc_KeyError, args);
+                Py_DECREF(args);
+            }
+        }
+    } else {
+        index = lazy_position(self, key);
+        if (index == -1) {
+            PyErr_SetString(PyExc_IndexError, "list index out of range");
+        }
+    }
+    if (index < 0) {
+        return NULL;
+    }
+    return lazy_value(self->document, index);
+}
+
+static PyObject *LazyNode_get(LazyNodeObject *self, PyObject *args) {
+    PyObject *key = NULL;
+    PyObject *default_value = Py_None;
+    Py_ssize_t index;
+    if (!PyArg_ParseTuple(args, "O|O:get", &key, &default_value)) {
+        return NULL;
+    }
+
+    if (lazy_is_object(self)) {
+        index = lazy_find(self, key);
+    } else {
+        index = PyIndex_Check(key) ? lazy_position(self, key) : -1;
+    }
+    if (index == -2) {
+        return NULL;
+    }
+    if (index == -1) {
+        Py_INCREF(default_value);
+        return default_value;
+    }
+    return lazy_value(self->document, index);
+}
+
+static int LazyNode_contains(LazyNodeObject *self, PyObject *value) {
+    const tape *const t = &self->document->tape;
+    Py_ssize_t index = self->index + 1;
+    Py_ssize_t i;
+
+    if (lazy_is_object(self)) {
+        index = lazy_find(self, value);
+        return (index == -2) ? -1 : (index >= 0);
+    }
+    for (i = 0; i < LazyNode_length(self); i++) {
+        PyObject *element = lazy_value(self->document, index);
+        int equal;
+
+        if (element == NULL) {
+            return -1;
+        }
+        equal = PyObject_RichCompareBool(element, value, Py_EQ);
+        Py_DECREF(element);
+        if (equal != 0) {
+            return equal;
+        }
+        index = lazy_next(t, index);
+    }
+    return 0;
+}
+
+static PyObject *LazyNode_iter(LazyNodeObject *self) {
+    LazyIteratorObject *iterator = PyObject_New(LazyIteratorObject, &LazyIteratorType);
+
+    if (iterator == NULL) {
+        return NULL;
+    }
+    Py_INCREF(self);
+    iterator->node = self;
+    iterator->index = self->index + 1;
+    iterator->remaining = LazyNode_length(self);
+    return (PyObject *) iterator;
+}
+
+static PyObject *LazyNode_materialize(LazyNodeObject *self, PyObject *Py_UNUSED(ignored)) {
+    Py_ssize_t index = self->index;
+
+    return tape_document(&self->document->buffer, &self->document->tape, &index, self->document->content);
+}
+
+static PyObject *LazyNode_repr(LazyNodeObject *self) {
+    if (lazy_is_object(self)) {
+        return PyUnicode_FromFormat("<cjson.Node object of %zd members>", LazyNode_length(self));
+    }
+    return PyUnicode_FromFormat("<cjson.Node array of %zd values>", LazyNode_length(self));
+}
+
+static PyMappingMethods LazyNode_as_mapping = {
+        .mp_length = (lenfunc) LazyNode_length,
+        .mp_subscript = (binaryfunc) LazyNode_subscript,
+};
+
+static PySequenceMethods LazyNode_as_sequence = {
+        .sq_contains = (objobjproc) LazyNode_contains,
+};
+
+static PyMethodDef LazyNode_methods[] = {
+        {"get", (PyCFunction) LazyNode_get, METH_VARARGS, "Returns the value of a key or index, or default if there is none."},
+        {"materialize", (PyCFunction) LazyNode_materialize, METH_NOARGS, "Creates the whole array or object, as loads does."},
+        {NULL, NULL, 0, NULL} /* Sentinel */
+};
+
+PyTypeObject LazyNodeType = {
+        PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "cjson.Node",
+        .tp_basicsize = sizeof(LazyNodeObject),
+        .tp_dealloc = (destructor) LazyNode_dealloc,
+        .tp_repr = (reprfunc) LazyNode_repr,
+        .tp_as_sequence = &LazyNode_as_sequence,
+        .tp_as_mapping = &LazyNode_as_mapping,
+        .tp_flags = Py_TPFLAGS_DEFAULT,
+        .tp_doc = "A read-only array or object of a document parsed by lazy_loads, its values are created when they are accessed.",
+        .tp_iter = (getiterfunc) LazyNode_iter,
+        .tp_methods = LazyNode_methods,
+};
+
+static void LazyIterator_dealloc(LazyIteratorObject *self) {
+    Py_DECREF(self->node);
+    PyObject_Free(self);
+}
+
+static PyObject *LazyIterator_next(LazyIteratorObject *self) {
+    LazyDocumentObject *const document = self->node->document;
+    PyObject *item = NULL;
+    Py_ssize_t index = self->index;
+
+    if (self->remaining == 0) {
+        return NULL;
+    }
+    if (lazy_is_object(self->node)) {
+        /* the key, the value follows it */
+        item = tape_document(&document->buffer, &document->tape, &index, document->content);
+        index = lazy_next(&document->tape, index);
+    } else {
+        item = lazy_value(document, index);
+        index = lazy_next(&document->tape, index);
+    }
+    if (item != NULL) {
+        self->index = index;
+        self->remaining--;
+    }
+    return item;
+}
+
+PyTypeObject LazyIteratorType = {
+        PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "cjson.NodeIterator",
+        .tp_basicsize = sizeof(LazyIteratorObject),
+        .tp_dealloc = (destructor) LazyIterator_dealloc,
+        .tp_flags = Py_TPFLAGS_DEFAULT,
+        .tp_doc = "Iterates over the values of an array node or the keys of an object node.",
+        .tp_iter = PyObject_SelfIter,
+        .tp_iternext = (iternextfunc) LazyIterator_next,
+};
+
+/* scan a whole document onto the tape, with the checks parse_text makes around its value */
+static bool lazy_scan(tape *const t, const unsigned char *const content, Py_ssize_t length, Py_ssize_t max_depth) {
+    const unsigned char *const end = content + length;
+    const unsigned char *pointer = content;
+
+    pointer += bom_length_utf8(pointer, end);
+    pointer = tape_skip_whitespace(pointer, end);
+    return tape_scan_value(t, content, &pointer, end, max_depth) && (pointer == end);
+}
+
+PyObject *pycJSON_DecodeLazy(PyObject *self, PyObject *args, PyObject *kwargs) {
+    parse_buffer buffer = PARSE_BUFFER_INIT;
+    LazyDocumentObject *document = NULL;
+    PyObject *arg = NULL;
+    PyObject *item = NULL;
+    Py_buffer view = {0};
+    bool valid;
+    static const char *kwlist[] = {"s", "max_depth", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|n", (char **) kwlist, &arg, &buffer.max_depth)) {
+        return NULL;
+    }
+
+    if (!check_options(&buffer)) {
+        return NULL;
+    }
+    document = PyObject_New(LazyDocumentObject, &LazyDocumentType);
+    if (document == NULL) {
+        return NULL;
+    }
+    memset(&document->source, 0, sizeof(LazyDocumentObject) - offsetof(LazyDocumentObject, source));
+    document->buffer = (parse_buffer) PARSE_BUFFER_INIT;
+    document->buffer.hooks = global_hooks;
+    document->buffer.max_depth = buffer.max_depth;
+
+    /* bytes and str are scanned in place, the values are created from them later */
+    if (PyUnicode_Check(arg)) {
+#if PY_VERSION_HEX < 0x030C0000
+        if (PyUnicode_READY(arg) < 0) {
+            goto fail;
+        }
+#endif
+        if (PyUnicode_IS_ASCII(arg)) {
+            document->content = (const unsigned char *) PyUnicode_DATA(arg);
+            document->length = PyUnicode_GET_LENGTH(arg);
+            Py_INCREF(arg);
+            document->source = arg;
+        } else {
+            /* scanned as a UTF-8 copy owned by the document rather than the one PyUnicode_AsUTF8 would cache on the
+             * str, errors are reported by the parser in characters */
+            document->source = PyUnicode_AsUTF8String(arg);
+            if (document->source == NULL) {
+                goto fail;
+            }
+            document->content = (const unsigned char *) PyBytes_AS_STRING(document->source);
+            document->length = PyBytes_GET_SIZE(document->source);
+        }
+    } else if (PyBytes_Check(arg)) {
+        document->content = (const unsigned char *) PyBytes_AS_STRING(arg);
+        document->length = PyBytes_GET_SIZE(arg);
+        Py_INCREF(arg);
+        document->source = arg;
+    } else if (PyObject_CheckBuffer(arg)) {
+        if (PyObject_GetBuffer(arg, &view, PyBUF_SIMPLE) < 0) {
+            goto fail;
+        }
+        document->copy = (unsigned char *) PyMem_Malloc((view.len > 0) ? (size_t) view.len : 1);
+        if (document->copy == NULL) {
+            PyBuffer_Release(&view);
+            PyErr_NoMemory();
+            goto fail;
+        }
+        memcpy(document->copy, view.buf, (size_t) view.len);
+        document->content = document->copy;
+        document->length = view.len;
+        PyBuffer_Release(&view);
+    } else {
+        PyErr_Format(PyExc_TypeError, "Failed to parse JSON: invalid argument, expected str / bytes-like object");
+        goto fail;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    valid = lazy_scan(&document->tape, document->content, document->length, buffer.max_depth);
+    Py_END_ALLOW_THREADS
+    if (document->tape.failed) {
+        PyErr_NoMemory();
+        goto fail;
+    }
+    if (!valid) {
+        /* the parser reports why */
+        if (PyUnicode_Check(arg)) {
+            item = parse_unicode_document(&buffer, arg, 1);
+        } else {
+            item = parse_document_utf8(&buffer, document->content, document->length);
+        }
+        Py_DECREF(document);
+        return item;
+    }
+    item = lazy_value(document, 0);
+    Py_DECREF(document);
+    return item;
+
+fail:
+    Py_DECREF(document);
+    return NULL;
+}
 
-    const char *value = NULL;
-    Py_ssize_t buffer_length;
-    static const char *kwlist[] = {"s", "object_hook", NULL};
-    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s#|O", (char **) kwlist, &value, &buffer_length, &buffer.object_hook)) {
-        PyErr_Format(PyExc_TypeError, "Failed to parse JSON: invalid argument, expected str / bytes-like object");
-        goto fail;
-    }
+/* one step of a compiled query path: the members of objects and elements of arrays it selects */
+typedef struct query_step {
+    PyObject *key; /* members with this name, NULL for none */
+    const char *key_utf8;
+    Py_ssize_t key_length;
+    Py_ssize_t index; /* the element at this index, -1 for none */
+    bool wildcard; /* every member and element */
+} query_step;
 
-    if (buffer.object_hook && !PyCallable_Check(buffer.object_hook)) {
-        PyErr_Format(PyExc_TypeError, "Failed to parse JSON: object_hook is not callable");
-        goto fail;
+typedef struct query_path {
+    query_step *steps;
+    Py_ssize_t size;
+    bool multiple; /* a step is a wildcard: the result is the list of the values selected */
+} query_path;
+
+/* paths compiled once by compile_query and evaluated over the raw input by extract */
+typedef struct
+{
+    PyObject_HEAD
+    PyObject *paths; /* tuple of the str they were compiled from */
+    query_path *compiled;
+    Py_ssize_t count;
+    Py_ssize_t steps; /* of the longest path */
+    Py_ssize_t max_depth;
+} QueryObject;
+
+/* the state of one extract */
+typedef struct query_walker {
+    const QueryObject *query;
+    parse_buffer buffer; /* creates the values selected */
+    const unsigned char *content;
+    const unsigned char *end;
+    tape keys; /* the key of the member being matched */
+    Py_ssize_t *selected; /* for each step, the paths that lead into the value walked there */
+    PyObject *results;
+} query_walker;
+
+extern PyTypeObject QueryType;
+
+/* a canonical array index, -1 if token is none */
+static Py_ssize_t query_index(const char *token, Py_ssize_t length) {
+    Py_ssize_t index = 0;
+    Py_ssize_t i;
+
+    if ((length == 0) || (length > 18) || ((token[0] == '0') && (length > 1))) {
+        return -1;
+    }
+    for (i = 0; i < length; i++) {
+        if ((token[i] < '0') || (token[i] > '9')) {
+            return -1;
+        }
+        index = index * 10 + (token[i] - '0');
     }
+    return index;
+}
 
-    if (0 == buffer_length) {
-        PyErr_SetString(PyExc_ValueError, "Empty string");
-        goto fail;
+static bool query_add_step(query_path *const path, const char *name, Py_ssize_t length, Py_ssize_t index, bool wildcard) {
+    query_step *new_steps = (query_step *) PyMem_Realloc(path->steps, (size_t) (path->size + 1) * sizeof(query_step));
+    query_step *step = NULL;
+
+    if (new_steps == NULL) {
+        PyErr_NoMemory();
+        return false;
     }
-    buffer.content = (const unsigned char *) value;
-    buffer.length = buffer_length;
-    buffer.offset = 0;
-    buffer.hooks = global_hooks;
-    if (!parse_value(&item, buffer_skip_whitespace(skip_utf8_bom(&buffer)))) {
-        /* parse failure. ep is set. */
-        goto fail;
+    path->steps = new_steps;
+    step = &path->steps[path->size];
+    memset(step, 0, sizeof(query_step));
+    step->index = index;
+    step->wildcard = wildcard;
+    if (name != NULL) {
+        step->key = PyUnicode_DecodeUTF8(name, length, NULL);
+        if (step->key == NULL) {
+            return false;
+        }
+        step->key_utf8 = PyUnicode_AsUTF8AndSize(step->key, &step->key_length);
+        if (step->key_utf8 == NULL) {
+            Py_CLEAR(step->key);
+            return false;
+        }
     }
-    if (buffer.offset < buffer.length) {
-        PyErr_Format(PyExc_ValueError, "Failed to parse JSON: extra characters at the end\nend position: %d", buffer.offset);
-        goto fail;
+    path->size++;
+    path->multiple |= wildcard;
+    return true;
+}
+
+static void query_path_free(query_path *const path) {
+    Py_ssize_t i;
+
+    for (i = 0; i < path->size; i++) {
+        Py_XDECREF(path->steps[i].key);
     }
-    if (dconv_s2d_ptr != NULL) {
-        dconv_s2d_free(&dconv_s2d_ptr);
+    PyMem_Free(path->steps);
+}
+
+/* Compile a JSON Pointer (RFC 6901): a token that is an array index selects that element of arrays too. Returns false
+ * without an error set if text is no valid pointer. */
+static bool query_compile_pointer(query_path *const path, const char *text, Py_ssize_t length, char *scratch) {
+    Py_ssize_t i = 0;
+
+    while (i < length) {
+        Py_ssize_t size = 0;
+
+        /* text[i] is the / before a token */
+        i++;
+        while ((i < length) && (text[i] != '/')) {
+            if (text[i] == '~') {
+                if ((i + 1 >= length) || ((text[i + 1] != '0') && (text[i + 1] != '1'))) {
+                    return false;
+                }
+                scratch[size++] = (text[i + 1] == '0') ? '~' : '/';
+                i += 2;
+                continue;
+            }
+            scratch[size++] = text[i++];
+        }
+        if (!query_add_step(path, scratch, size, query_index(scratch, size), false)) {
+            return false;
+        }
     }
-    return item;
+    return true;
+}
 
-fail:
-    Py_XDECREF(item);
-    if (value != NULL && !PyErr_Occurred()) {
-        Py_ssize_t position = 0;
+/* Compile the JSONPath subset of $, .name, .*, ['name'], ["name"], [index] and [*]. Returns false without an error
+ * set if text is not in it. */
+static bool query_compile_jsonpath(query_path *const path, const char *text, Py_ssize_t length, char *scratch) {
+    Py_ssize_t i = 1; /* after the $ */
+
+    while (i < length) {
+        Py_ssize_t size = 0;
+        bool added;
+
+        if ((text[i] == '.') && (i + 1 < length) && (text[i + 1] == '*')) {
+            added = query_add_step(path, NULL, 0, -1, true);
+            i += 2;
+        } else if (text[i] == '.') {
+            i++;
+            while ((i < length) && (text[i] != '.') && (text[i] != '[')) {
+                scratch[size++] = text[i++];
+            }
+            if (size == 0) {
+                return false;
+            }
+            added = query_add_step(path, scratch, size, -1, false);
+        } else if (text[i] == '[') {
+            i++;
+            if ((i < length) && (text[i] == '*')) {
+                added = query_add_step(path, NULL, 0, -1, true);
+                i++;
+            } else if ((i < length) && ((text[i] == '\'') || (text[i] == '\"'))) {
+                const char quote = text[i++];
 
-        if (buffer.offset < buffer.length) {
-            position = buffer.offset;
-        } else if (buffer.length > 0) {
-            position = buffer.length - 1;
+                while ((i < length) && (text[i] != quote)) {
+                    if ((text[i] == '\\') && (i + 1 < length)) {
+                        i++;
+                    }
+                    scratch[size++] = text[i++];
+                }
+                if (i >= length) {
+                    return false;
+                }
+                i++;
+                added = query_add_step(path, scratch, size, -1, false);
+            } else {
+                while ((i < length) && (text[i] >= '0') && (text[i] <= '9')) {
+                    scratch[size++] = text[i++];
+                }
+                if (query_index(scratch, size) < 0) {
+                    return false;
+                }
+                added = query_add_step(path, NULL, 0, query_index(scratch, size), false);
+            }
+            if (!added || (i >= length) || (text[i] != ']')) {
+                return false;
+            }
+            i++;
+            continue;
+        } else {
+            return false;
+        }
+        if (!added) {
+            return false;
         }
+    }
+    return true;
+}
 
-        PyErr_Format(PyExc_ValueError, "Failed to parse JSON (position %d)", position);
+static void Query_dealloc(QueryObject *self) {
+    Py_ssize_t i;
+
+    for (i = 0; i < self->count; i++) {
+        query_path_free(&self->compiled[i]);
     }
-    if (dconv_s2d_ptr != NULL) {
-        dconv_s2d_free(&dconv_s2d_ptr);
+    PyMem_Free(self->compiled);
+    Py_XDECREF(self->paths);
+    PyObject_Free(self);
+}
+
+static PyObject *Query_get_paths(QueryObject *self, void *Py_UNUSED(closure)) {
+    Py_INCREF(self->paths);
+    return self->paths;
+}
+
+/* skip the string whose opening quote is before pointer, NULL if it does not end */
+static const unsigned char *query_skip_string(const unsigned char *pointer, const unsigned char *const end) {
+    while (pointer < end) {
+        const unsigned char *const quote = (const unsigned char *) memchr(pointer, '\"', (size_t) (end - pointer));
+        const unsigned char *backslashes = quote;
+
+        if (quote == NULL) {
+            return NULL;
+        }
+        while ((backslashes > pointer) && (backslashes[-1] == '\\')) {
+            backslashes--;
+        }
+        if (((quote - backslashes) & 1) == 0) {
+            return quote + 1;
+        }
+        pointer = quote + 1;
     }
     return NULL;
 }
 
-PyObject *pycJSON_DecodeFile(PyObject *self, PyObject *args, PyObject *kwargs) {
-    parse_buffer buffer = {0, 0, 0, 0, {0, 0}, 0};
+/* Skip the value at pointer by matching brackets outside of strings, nothing in it is validated or created. Returns
+ * where it ends, NULL if there is no value or it does not end. */
+static const unsigned char *query_skip_value(const unsigned char *pointer, const unsigned char *const end) {
+    const unsigned char *const start = pointer;
+    Py_ssize_t depth = 0;
+
+    while (pointer < end) {
+        switch (*pointer) {
+            case '\"':
+                pointer = query_skip_string(pointer + 1, end);
+                if (pointer == NULL) {
+                    return NULL;
+                }
+                if (depth == 0) {
+                    return pointer;
+                }
+                continue;
+            case '[':
+            case '{':
+                depth++;
+                break;
+            case ']':
+            case '}':
+                if (depth == 0) {
+                    return (pointer > start) ? pointer : NULL;
+                }
+                if (--depth == 0) {
+                    return pointer + 1;
+                }
+                break;
+            case ',':
+                if (depth == 0) {
+                    return (pointer > start) ? pointer : NULL;
+                }
+                break;
+            default:
+                break;
+        }
+        pointer++;
+    }
+    return ((depth == 0) && (pointer > start)) ? pointer : NULL;
+}
+
+/* 1 if the key just scanned is the name of step, -1 with an error set */
+static int query_key_equal(query_walker *const w, const query_step *const step) {
+    const tape_entry *const entry = &w->keys.entries[0];
+    PyObject *key = NULL;
+    int equal;
+
+    if (entry->raw) {
+        return (entry->length == step->key_length) && (memcmp(w->content + entry->start, step->key_utf8, (size_t) step->key_length) == 0);
+    }
+    key = tape_string(entry, w->content);
+    if (key == NULL) {
+        return -1;
+    }
+    equal = PyUnicode_Compare(key, step->key) == 0;
+    Py_DECREF(key);
+    return equal;
+}
+
+static bool query_walk_value(query_walker *const w, const unsigned char **pointer, Py_ssize_t depth, Py_ssize_t size);
+
+/* Walk the members or elements of the container at *pointer for the paths that lead into it, leaving *pointer after
+ * it. Returns false with an error set, or without one if the container is invalid. */
+static bool query_walk_container(query_walker *const w, const unsigned char **pointer, Py_ssize_t depth, Py_ssize_t size) {
+    const QueryObject *const query = w->query;
+    const Py_ssize_t *const paths = w->selected + depth * query->count;
+    Py_ssize_t *const children = w->selected + (depth + 1) * query->count;
+    const unsigned char close = (**pointer == '{') ? '}' : ']';
+    const unsigned char *p = tape_skip_whitespace(*pointer + 1, w->end);
+    Py_ssize_t position = 0;
+
+    if ((p < w->end) && (*p == close)) {
+        *pointer = p + 1;
+        return true;
+    }
+    for (;;) {
+        Py_ssize_t selected = 0;
+        Py_ssize_t i;
+
+        if (close == '}') {
+            w->keys.size = 0;
+            if (!tape_reserve(&w->keys)) {
+                PyErr_NoMemory();
+                return false;
+            }
+            if ((p >= w->end) || (*p != '\"') || !tape_scan_string(&w->keys, TAPE_KEY, w->content, &p, w->end)) {
+                return false;
+            }
+            p = tape_skip_whitespace(p, w->end);
+            if ((p >= w->end) || (*p != ':')) {
+                return false;
+            }
+            p = tape_skip_whitespace(p + 1, w->end);
+        }
+        for (i = 0; i < size; i++) {
+            const query_path *const path = &query->compiled[paths[i]];
+            const query_step *step = NULL;
+            int match;
+
+            if (path->size == depth) {
+                continue;
+            }
+            step = &path->steps[depth];
+            if (step->wildcard) {
+                match = 1;
+            } else if (close == '}') {
+                match = (step->key != NULL) ? query_key_equal(w, step) : 0;
+            } else {
+                match = step->index == position;
+            }
+            if (match < 0) {
+                return false;
+            }
+            if (match) {
+                children[selected++] = paths[i];
+                if (!path->multiple) {
+                    /* a later duplicate key replaces what an earlier one led to, as in loads */
+                    Py_INCREF(Py_None);
+                    PyList_SetItem(w->results, paths[i], Py_None);
+                }
+            }
+        }
+        if (selected > 0) {
+            if (!query_walk_value(w, &p, depth + 1, selected)) {
+                return false;
+            }
+        } else {
+            p = query_skip_value(p, w->end);
+            if (p == NULL) {
+                return false;
+            }
+        }
+        p = tape_skip_whitespace(p, w->end);
+        position++;
+        if ((p < w->end) && (*p == ',')) {
+            p = tape_skip_whitespace(p + 1, w->end);
+            continue;
+        }
+        if ((p < w->end) && (*p == close)) {
+            *pointer = p + 1;
+            return true;
+        }
+        return false;
+    }
+}
+
+/* Walk the value at *pointer for the size paths that lead into it, leaving *pointer after it. The value is created
+ * for the paths that end at it, and only walked into for the others. */
+static bool query_walk_value(query_walker *const w, const unsigned char **pointer, Py_ssize_t depth, Py_ssize_t size) {
+    const QueryObject *const query = w->query;
+    const Py_ssize_t *const paths = w->selected + depth * query->count;
+    const unsigned char *const start = *pointer;
     PyObject *item = NULL;
-    PyObject *file_obj = NULL;
-    PyObject *read_method = NULL;
-    PyObject *file_contents = NULL;
-    const char *value = NULL;
-    Py_ssize_t buffer_length;
-    static const char *kwlist[] = {"fp", "object_hook", NULL};
-    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O", (char **) kwlist, &file_obj, &buffer.object_hook)) {
-        PyErr_Format(PyExc_TypeError, "Failed to parse JSON: invalid argument, expected str / bytes-like object");
-        goto fail;
+    bool ends = false;
+    bool walked = false;
+    Py_ssize_t i;
+
+    for (i = 0; i < size; i++) {
+        if (query->compiled[paths[i]].size == depth) {
+            ends = true;
+        } else {
+            walked = true;
+        }
+    }
+    walked = walked && (start < w->end) && ((*start == '[') || (*start == '{'));
+    if (walked) {
+        if (depth >= query->max_depth) {
+            /* too deeply nested, the parser reports it */
+            return false;
+        }
+        if (!query_walk_container(w, pointer, depth, size)) {
+            return false;
+        }
+    } else if (!ends) {
+        /* a scalar where the paths need a container: they select nothing */
+        *pointer = query_skip_value(start, w->end);
+        return *pointer != NULL;
+    }
+    if (!ends) {
+        return true;
     }
 
-    if (!PyObject_HasAttrString(file_obj, "read")) {
-        PyErr_SetString(PyExc_TypeError, "object must have a 'read' method");
-        goto fail;
+    w->buffer.offset = start - w->content;
+    w->buffer.state = STATE_VALUE;
+    /* the value is parsed on its own, the containers it is in count against max_depth */
+    w->buffer.max_depth = query->max_depth - depth;
+    if (!parse_value_utf8(&item, &w->buffer)) {
+        if (PyErr_ExceptionMatches(PyExc_ValueError)) {
+            /* an error before this value is found first by the parser, as in loads */
+            PyErr_Clear();
+        }
+        return false;
+    }
+    if (!walked) {
+        *pointer = w->content + w->buffer.offset;
     }
+    for (i = 0; i < size; i++) {
+        const Py_ssize_t index = paths[i];
 
-    read_method = PyObject_GetAttrString(file_obj, "read");
-    if (!PyCallable_Check(read_method)) {
-        PyErr_SetString(PyExc_TypeError, "'read' method is not callable");
-        goto fail;
+        if (query->compiled[index].size != depth) {
+            continue;
+        }
+        if (query->compiled[index].multiple) {
+            if (PyList_Append(PyList_GET_ITEM(w->results, index), item) < 0) {
+                Py_DECREF(item);
+                return false;
+            }
+        } else {
+            Py_INCREF(item);
+            PyList_SetItem(w->results, index, item);
+        }
     }
+    Py_DECREF(item);
+    return true;
+}
 
-    file_contents = PyObject_CallObject(read_method, NULL);
-    if (file_contents == NULL) {
-        PyErr_SetString(PyExc_ValueError, "Failed to read file contents");
-        goto fail;
+/* evaluate the query over a document in UTF-8, the results are in the order of the paths */
+static PyObject *query_extract(const QueryObject *const query, const unsigned char *const content, Py_ssize_t length) {
+    query_walker w = {query, PARSE_BUFFER_INIT, content, content + length, {0}, NULL, NULL};
+    const unsigned char *pointer = content;
+    PyObject *result = NULL;
+    Py_ssize_t i;
+
+    w.buffer.hooks = global_hooks;
+    w.buffer.content = content;
+    w.buffer.length = length;
+    w.buffer.max_depth = query->max_depth;
+    w.selected = (Py_ssize_t *) PyMem_Malloc((size_t) ((query->steps + 1) * query->count + 1) * sizeof(Py_ssize_t));
+    w.results = PyList_New(query->count);
+    if ((w.selected == NULL) || (w.results == NULL)) {
+        if (w.selected == NULL) {
+            PyErr_NoMemory();
+        }
+        goto cleanup;
     }
+    for (i = 0; i < query->count; i++) {
+        PyObject *initial = query->compiled[i].multiple ? PyList_New(0) : Py_None;
 
-    // set value and buffer_length
-    if (PyUnicode_Check(file_contents)) {
-        value = PyUnicode_AsUTF8(file_contents);
-        if (value == NULL) {
-            PyErr_SetString(PyExc_ValueError, "Failed to parse JSON: value is NULL");
-            goto fail;
+        if (initial == NULL) {
+            goto cleanup;
         }
-        buffer_length = strlen(value);
-    } else if (PyBytes_Check(file_contents)) {
-        value = PyBytes_AsString(file_contents);
-        if (value == NULL) {
-            PyErr_SetString(PyExc_ValueError, "Failed to parse JSON: value is NULL");
-            goto fail;
+        if (initial == Py_None) {
+            Py_INCREF(initial);
         }
-        buffer_length = PyBytes_Size(file_contents);
+        PyList_SET_ITEM(w.results, i, initial);
+        w.selected[i] = i;
+    }
+
+    pointer += bom_length_utf8(pointer, w.end);
+    pointer = tape_skip_whitespace(pointer, w.end);
+    if (query_walk_value(&w, &pointer, 0, query->count) && (pointer == w.end)) {
+        result = w.results;
+        w.results = NULL;
+    } else if (!PyErr_Occurred()) {
+        /* the parser reports why the document is invalid */
+        parse_buffer buffer = PARSE_BUFFER_INIT;
+        PyObject *item = NULL;
+
+        buffer.max_depth = query->max_depth;
+        item = parse_document_utf8(&buffer, content, length);
+        if (item != NULL) {
+            Py_DECREF(item);
+            PyErr_Format(PyExc_ValueError, "Failed to parse JSON: invalid document");
+        }
+    }
+
+cleanup:
+    Py_XDECREF(w.results);
+    PyMem_Free(w.selected);
+    PyMem_RawFree(w.keys.entries);
+    parse_buffer_free(&w.buffer);
+    return result;
+}
+
+static PyObject *Query_extract(QueryObject *self, PyObject *arg) {
+    PyObject *result = NULL;
+    PyObject *utf8 = NULL;
+    Py_buffer view = {0};
+    const char *content = NULL;
+    Py_ssize_t length = 0;
+
+    if (PyUnicode_Check(arg)) {
+#if PY_VERSION_HEX < 0x030C0000
+        if (PyUnicode_READY(arg) < 0) {
+            return NULL;
+        }
+#endif
+        if (PyUnicode_IS_ASCII(arg)) {
+            content = (const char *) PyUnicode_DATA(arg);
+            length = PyUnicode_GET_LENGTH(arg);
+        } else {
+            /* walked as a UTF-8 copy rather than the one PyUnicode_AsUTF8AndSize would cache on the str */
+            utf8 = PyUnicode_AsUTF8String(arg);
+            if (utf8 == NULL) {
+                return NULL;
+            }
+            content = PyBytes_AS_STRING(utf8);
+            length = PyBytes_GET_SIZE(utf8);
+        }
+    } else if (PyObject_CheckBuffer(arg)) {
+        if (PyObject_GetBuffer(arg, &view, PyBUF_SIMPLE) < 0) {
+            return NULL;
+        }
+        content = (const char *) view.buf;
+        length = view.len;
     } else {
-        PyErr_SetString(PyExc_ValueError, "file content must be a string");
-        goto fail;
+        PyErr_Format(PyExc_TypeError, "Failed to parse JSON: invalid argument, expected str / bytes-like object");
+        return NULL;
     }
 
-    if (buffer.object_hook && !PyCallable_Check(buffer.object_hook)) {
-        PyErr_Format(PyExc_TypeError, "Failed to parse JSON: object_hook is not callable");
-        goto fail;
+    result = query_extract(self, (const unsigned char *) content, length);
+    if ((result == NULL) && (utf8 != NULL) && PyErr_ExceptionMatches(PyExc_ValueError)) {
+        /* the position is in bytes of the copy, the parser reports the error in characters of the str */
+        parse_buffer buffer = PARSE_BUFFER_INIT;
+        PyObject *item = NULL;
+
+        PyErr_Clear();
+        buffer.max_depth = self->max_depth;
+        item = parse_unicode_document(&buffer, arg, 1);
+        if (item != NULL) {
+            Py_DECREF(item);
+            PyErr_Format(PyExc_ValueError, "Failed to parse JSON: invalid document");
+        }
     }
+    Py_XDECREF(utf8);
+    PyBuffer_Release(&view);
+    return result;
+}
 
-    if (0 == buffer_length) {
-        PyErr_SetString(PyExc_ValueError, "Empty string");
-        goto fail;
+static PyMethodDef Query_methods[] = {
+        {"extract", (PyCFunction) Query_extract, METH_O, "Returns the values the paths select in a JSON document, in the order of the paths."},
+        {NULL, NULL, 0, NULL} /* Sentinel */
+};
+
+static PyGetSetDef Query_getset[] = {
+        {"paths", (getter) Query_get_paths, NULL, "The paths the query was compiled from.", NULL},
+        {NULL, NULL, NULL, NULL, NULL} /* Sentinel */
+};
+
+PyTypeObject QueryType = {
+        PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "cjson.Query",
+        .tp_basicsize = sizeof(QueryObject),
+        .tp_dealloc = (destructor) Query_dealloc,
+        .tp_flags = Py_TPFLAGS_DEFAULT,
+        .tp_doc = "JSON Pointer and JSONPath paths compiled by compile_query.",
+        .tp_methods = Query_methods,
+        .tp_getset = Query_getset,
+};
+
+PyObject *pycJSON_CompileQuery(PyObject *self, PyObject *args, PyObject *kwargs) {
+    QueryObject *query = NULL;
+    PyObject *arg = NULL;
+    Py_ssize_t max_depth = CJSON_NESTING_LIMIT;
+    char *scratch = NULL;
+    Py_ssize_t i;
+    static const char *kwlist[] = {"paths", "max_depth", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|n", (char **) kwlist, &arg, &max_depth)) {
+        return NULL;
     }
-    buffer.content = (const unsigned char *) value;
-    buffer.length = buffer_length;
-    buffer.offset = 0;
-    buffer.hooks = global_hooks;
-    if (!parse_value(&item, buffer_skip_whitespace(skip_utf8_bom(&buffer)))) {
-        /* parse failure. ep is set. */
+
+    if (max_depth < 0) {
+        PyErr_Format(PyExc_ValueError, "Failed to compile query: max_depth must not be negative");
+        return NULL;
+    }
+    if (PyUnicode_Check(arg)) {
+        PyErr_Format(PyExc_TypeError, "Failed to compile query: expected a sequence of paths, not a str");
+        return NULL;
+    }
+    query = PyObject_New(QueryObject, &QueryType);
+    if (query == NULL) {
+        return NULL;
+    }
+    memset(&query->paths, 0, sizeof(QueryObject) - offsetof(QueryObject, paths));
+    query->max_depth = max_depth;
+    query->paths = PySequence_Tuple(arg);
+    if (query->paths == NULL) {
         goto fail;
     }
-    if (buffer.offset < buffer.length) {
-        PyErr_Format(PyExc_ValueError, "Failed to parse JSON: extra characters at the end\nend position: %d", buffer.offset);
+    query->compiled = (query_path *) PyMem_Calloc((size_t) PyTuple_GET_SIZE(query->paths) + 1, sizeof(query_path));
+    if (query->compiled == NULL) {
+        PyErr_NoMemory();
         goto fail;
     }
 
-    Py_XDECREF(file_contents);
-    Py_XDECREF(read_method);
+    for (i = 0; i < PyTuple_GET_SIZE(query->paths); i++) {
+        PyObject *path = PyTuple_GET_ITEM(query->paths, i);
+        const char *text = NULL;
+        Py_ssize_t length = 0;
+        bool compiled = false;
 
-    return item;
+        if (!PyUnicode_Check(path)) {
+            PyErr_Format(PyExc_TypeError, "Failed to compile query: paths must be str, not %.200s", Py_TYPE(path)->tp_name);
+            goto fail;
+        }
+        text = PyUnicode_AsUTF8AndSize(path, &length);
+        if (text == NULL) {
+            goto fail;
+        }
+        /* the names of a path are never longer than it */
+        PyMem_Free(scratch);
+        scratch = (char *) PyMem_Malloc((size_t) length + 1);
+        if (scratch == NULL) {
+            PyErr_NoMemory();
+            goto fail;
+        }
+        query->count++;
+        if ((length == 0) || (text[0] == '/')) {
+            compiled = query_compile_pointer(&query->compiled[i], text, length, scratch);
+        } else if (text[0] == '$') {
+            compiled = query_compile_jsonpath(&query->compiled[i], text, length, scratch);
+        }
+        if (!compiled) {
+            if (!PyErr_Occurred()) {
+                PyErr_Format(PyExc_ValueError, "Failed to compile query: invalid path %R", path);
+            }
+            goto fail;
+        }
+        if (query->compiled[i].size > query->steps) {
+            query->steps = query->compiled[i].size;
+        }
+    }
+    PyMem_Free(scratch);
+    return (PyObject *) query;
 
 fail:
-    if (value != NULL && !PyErr_Occurred()) {
-        Py_ssize_t position = 0;
+    PyMem_Free(scratch);
+    Py_DECREF(query);
+    return NULL;
+}
 
-        if (buffer.offset < buffer.length) {
-            position = buffer.offset;
-        } else if (buffer.length > 0) {
-            position = buffer.length - 1;
-        }
+extern PyObject *JSONDecodeError;
+
+/* the JSONDecodeError that validate returns for an invalid document, with msg, pos, lineno and colno as in json */
+static PyObject *validate_result(const validate_error *const error) {
+    PyObject *message = PyUnicode_FromFormat(error->message, error->arguments[0], error->arguments[1]);
+    PyObject *text = NULL;
+    PyObject *exception = NULL;
+    PyObject *number = NULL;
 
-        PyErr_Format(PyExc_ValueError, "Failed to parse JSON (position %d)", position);
+    if (message == NULL) {
+        return NULL;
+    }
+    if (strcmp(error->message, "Empty string") == 0) {
+        Py_INCREF(message);
+        text = message;
+    } else {
+        text = PyUnicode_FromFormat("%U\n%s: %zd", message, error->at_end ? "end position" : "position", error->position);
+    }
+    if (text != NULL) {
+        exception = PyObject_CallFunctionObjArgs(JSONDecodeError, text, NULL);
+    }
+    if ((exception != NULL) && (PyObject_SetAttrString(exception, "msg", message) < 0)) {
+        Py_CLEAR(exception);
+    }
+    if ((exception != NULL) && (((number = PyLong_FromSsize_t(error->position)) == NULL) || (PyObject_SetAttrString(exception, "pos", number) < 0))) {
+        Py_CLEAR(exception);
     }
+    Py_XDECREF(number);
+    if ((exception != NULL) && (((number = PyLong_FromSsize_t(error->lineno)) == NULL) || (PyObject_SetAttrString(exception, "lineno", number) < 0))) {
+        Py_CLEAR(exception);
+    }
+    Py_XDECREF(number);
+    if ((exception != NULL) && (((number = PyLong_FromSsize_t(error->colno)) == NULL) || (PyObject_SetAttrString(exception, "colno", number) < 0))) {
+        Py_CLEAR(exception);
+    }
+    Py_XDECREF(number);
+    Py_XDECREF(text);
+    Py_DECREF(message);
+    return exception;
+}
 
-    Py_XDECREF(file_contents);
-    Py_XDECREF(read_method);
-    Py_XDECREF(item);
+PyObject *pycJSON_Validate(PyObject *self, PyObject *args, PyObject *kwargs) {
+    parse_buffer buffer = PARSE_BUFFER_INIT;
+    validate_error error = {NULL, {0, 0}, 0, false, 0, 0};
+    PyObject *arg = NULL;
+    PyObject *result = NULL;
+    Py_buffer view = {0};
+    const void *content = NULL;
+    Py_ssize_t length = 0;
+    int kind = 0; /* 0 for UTF-8, the kind of a str that is not ASCII otherwise */
+    Py_ssize_t max_digits = 0;
+    bool valid;
+    static const char *kwlist[] = {"s", "max_depth", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|n", (char **) kwlist, &arg, &buffer.max_depth)) {
+        return NULL;
+    }
 
-    return NULL;
+    if (!check_options(&buffer)) {
+        return NULL;
+    }
+    /* read here, the GIL is released while the document is checked */
+    max_digits = int_max_str_digits();
+    if (max_digits < 0) {
+        return NULL;
+    }
+    /* str is validated in its own representation, so that positions count its characters */
+    if (PyUnicode_Check(arg)) {
+#if PY_VERSION_HEX < 0x030C0000
+        if (PyUnicode_READY(arg) < 0) {
+            return NULL;
+        }
+#endif
+        content = PyUnicode_DATA(arg);
+        length = PyUnicode_GET_LENGTH(arg);
+        if (!PyUnicode_IS_ASCII(arg)) {
+            kind = PyUnicode_KIND(arg);
+        }
+    } else if (PyObject_CheckBuffer(arg)) {
+        if (PyObject_GetBuffer(arg, &view, PyBUF_SIMPLE) < 0) {
+            return NULL;
+        }
+        content = view.buf;
+        length = view.len;
+    } else {
+        PyErr_Format(PyExc_TypeError, "Failed to parse JSON: invalid argument, expected str / bytes-like object");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    switch (kind) {
+        case 0:
+            valid = validate_text_utf8((const Py_UCS1 *) content, length, buffer.max_depth, max_digits, &error);
+            break;
+        case PyUnicode_1BYTE_KIND:
+            valid = validate_text_ucs1((const Py_UCS1 *) content, length, buffer.max_depth, max_digits, &error);
+            break;
+        case PyUnicode_2BYTE_KIND:
+            valid = validate_text_ucs2((const Py_UCS2 *) content, length, buffer.max_depth, max_digits, &error);
+            break;
+        default:
+            valid = validate_text_ucs4((const Py_UCS4 *) content, length, buffer.max_depth, max_digits, &error);
+            break;
+    }
+    Py_END_ALLOW_THREADS
+    if (valid) {
+        Py_INCREF(Py_True);
+        result = Py_True;
+    } else if (error.message == NULL) {
+        PyErr_NoMemory();
+    } else {
+        result = validate_result(&error);
+    }
+    PyBuffer_Release(&view);
+    return result;
 }
@@ -0,0 +1,1296 @@
+/* Parser core, included by pycJSON_decode.c once for every representation of the input.
+ * Before including this file, define
+ *   CHAR_T       the code unit of the input (Py_UCS1, Py_UCS2 or Py_UCS4)
+ *   CHAR_SIZE    sizeof(CHAR_T), for the preprocessor
+ *   DECODE_UTF8  1 if strings hold UTF-8 that has to be decoded, 0 if every code unit is a code point
+ *   PARSER(name) the name of a function of this instantiation
+ * All of them are undefined again at the end of this file. */
+
+/* get a pointer to the buffer at the position */
+#define buffer_at_offset(buffer) ((const CHAR_T *) (buffer)->content + (buffer)->offset)
+#define buffer_end(buffer) ((const CHAR_T *) (buffer)->content + (buffer)->length)
+
+#if (CHAR_SIZE == 1) && defined(PYCJSON_USE_SSE2)
+/* classify the rest of a long run of whitespace 16 bytes at a time */
+static const CHAR_T *PARSER(skip_whitespace_run)(const CHAR_T *pointer, const CHAR_T *const end) {
+    unsigned int mask;
+    while ((mask = non_whitespace_mask(pointer)) == 0) {
+        pointer += 16;
+        if ((end - pointer) < 16) {
+            return pointer;
+        }
+    }
+    return pointer + count_trailing_zeros(mask);
+}
+#endif
+
+/* Utility to jump whitespace and cr/lf. It stays on the last whitespace character when the whitespace runs to the end,
+ * where the errors of the parser point. */
+static inline const CHAR_T *PARSER(skip_whitespace)(const CHAR_T *pointer, const CHAR_T *const end) {
+    if ((pointer >= end) || (*pointer > 32)) {
+        /* most values are not preceded by whitespace */
+        return pointer;
+    }
+
+    while ((pointer < end) && (*pointer <= 32)) {
+        pointer++;
+#if (CHAR_SIZE == 1) && defined(PYCJSON_USE_SSE2)
+        /* a second whitespace character is usually indentation */
+        if (((end - pointer) >= 16) && (*pointer <= 32)) {
+            pointer = PARSER(skip_whitespace_run)(pointer, end);
+        }
+#endif
+    }
+
+    return (pointer == end) ? pointer - 1 : pointer;
+}
+
+static inline void PARSER(buffer_skip_whitespace)(parse_buffer *const buffer) {
+    buffer->offset = (Py_ssize_t) (PARSER(skip_whitespace)(buffer_at_offset(buffer), buffer_end(buffer)) - (const CHAR_T *) buffer->content);
+}
+
+/* the length of the byte order mark at pointer, 0 if there is none */
+static inline Py_ssize_t PARSER(bom_length)(const CHAR_T *const pointer, const CHAR_T *const end) {
+#if DECODE_UTF8
+    if (((end - pointer) >= 3) && (memcmp(pointer, "\xEF\xBB\xBF", 3) == 0)) {
+        return 3;
+    }
+#elif CHAR_SIZE > 1
+    if ((pointer < end) && (*pointer == 0xFEFF)) {
+        return 1;
+    }
+#else
+    (void) pointer;
+    (void) end;
+#endif
+    return 0;
+}
+
+/* skip the byte order mark if it is at the beginning of a buffer */
+static void PARSER(skip_bom)(parse_buffer *const buffer) {
+    buffer->offset += PARSER(bom_length)(buffer_at_offset(buffer), buffer_end(buffer));
+}
+
+#if CHAR_SIZE == 1
+#define scan_string_plain scan_string_ascii
+#define scan_string_special scan_string_unicode
+#else
+/* length of the run before the first quote, backslash or non-ASCII character */
+static inline Py_ssize_t PARSER(scan_string_plain)(const CHAR_T *const input, const CHAR_T *const input_end) {
+    const CHAR_T *pointer = input;
+    while ((pointer < input_end) && (*pointer != '\"') && (*pointer != '\\') && (*pointer < 0x80)) {
+        pointer++;
+    }
+    return (Py_ssize_t) (pointer - input);
+}
+
+/* length of the run before the first quote or backslash */
+static inline Py_ssize_t PARSER(scan_string_special)(const CHAR_T *const input, const CHAR_T *const input_end) {
+    const CHAR_T *pointer = input;
+    while ((pointer < input_end) && (*pointer != '\"') && (*pointer != '\\')) {
+        pointer++;
+    }
+    return (Py_ssize_t) (pointer - input);
+}
+#define scan_string_plain PARSER(scan_string_plain)
+#define scan_string_special PARSER(scan_string_special)
+#endif
+
+/* parse 4 digit hexadecimal number, returns a value above 0xFFFF if a digit is invalid */
+static unsigned PARSER(parse_hex4)(const CHAR_T *const input) {
+    unsigned int h = 0;
+    Py_ssize_t i = 0;
+    for (i = 0; i < 4; i++) {
+        /* parse digit */
+        if ((input[i] >= '0') && (input[i] <= '9')) {
+            h += (unsigned int) input[i] - '0';
+        } else if ((input[i] >= 'A') && (input[i] <= 'F')) {
+            h += (unsigned int) 10 + input[i] - 'A';
+        } else if ((input[i] >= 'a') && (input[i] <= 'f')) {
+            h += (unsigned int) 10 + input[i] - 'a';
+        } else /* invalid */
+        {
+            return UINT_MAX;
+        }
+
+        if (i < 3) {
+            /* shift left to make place for the next nibble */
+            h = h << 4;
+        }
+    }
+
+    return h;
+}
+
+/* converts a UTF-16 literal to a code point, returns the length of the literal or 0 if it is invalid
+ * A literal can be one or two sequences of the form \uXXXX */
+static unsigned char PARSER(parse_utf16_literal)(const CHAR_T *const input_pointer, const CHAR_T *const input_end, Py_UCS4 *codepoint) {
+    unsigned int first_code = 0;
+    const CHAR_T *first_sequence = input_pointer;
+
+    if ((input_end - first_sequence) < 6) {
+        /* input ends unexpectedly */
+        return 0;
+    }
+
+    /* get the first utf16 sequence */
+    first_code = PARSER(parse_hex4)(first_sequence + 2);
+
+    /* check that the code is valid */
+    if ((first_code > 0xFFFF) || ((first_code >= 0xDC00) && (first_code <= 0xDFFF))) {
+        return 0;
+    }
+
+    /* UTF16 surrogate pair */
+    if ((first_code >= 0xD800) && (first_code <= 0xDBFF)) {
+        const CHAR_T *second_sequence = first_sequence + 6;
+        unsigned int second_code = 0;
+
+        if ((input_end - second_sequence) < 6) {
+            /* input ends unexpectedly */
+            return 0;
+        }
+
+        if ((second_sequence[0] != '\\') || (second_sequence[1] != 'u')) {
+            /* missing second half of the surrogate pair */
+            return 0;
+        }
+
+        /* get the second utf16 sequence */
+        second_code = PARSER(parse_hex4)(second_sequence + 2);
+        /* check that the code is valid */
+        if ((second_code < 0xDC00) || (second_code > 0xDFFF)) {
+            /* invalid second half of the surrogate pair */
+            return 0;
+        }
+
+        /* calculate the unicode codepoint from the surrogate pair */
+        *codepoint = 0x10000 + (((first_code & 0x3FF) << 10) | (second_code & 0x3FF));
+        return 12; /* \uXXXX\uXXXX */
+    }
+
+    *codepoint = first_code;
+    return 6; /* \uXXXX */
+}
+
+/* decode the escape sequence or non-ASCII character at input into codepoint,
+ * returns its length in code units or 0 with the reason in error if it is invalid */
+static inline Py_ssize_t PARSER(decode_special)(const CHAR_T *const input, const CHAR_T *const input_end, Py_UCS4 *codepoint, string_error *error) {
+    unsigned char sequence_length = 0;
+
+    if (*input != '\\') {
+#if DECODE_UTF8
+        sequence_length = decode_utf8(input, input_end, codepoint);
+        if (sequence_length == 0) {
+            *error = STRING_INVALID_UTF8;
+        }
+        return sequence_length;
+#else
+        *codepoint = *input;
+        return 1;
+#endif
+    }
+
+    if ((input_end - input) < 2) {
+        /* prevent buffer overflow when last input character is a backslash */
+        *error = STRING_BACKSLASH_AT_END;
+        return 0;
+    }
+    switch (input[1]) {
+        case 'b':
+            *codepoint = '\b';
+            return 2;
+        case 'f':
+            *codepoint = '\f';
+            return 2;
+        case 'n':
+            *codepoint = '\n';
+            return 2;
+        case 'r':
+            *codepoint = '\r';
+            return 2;
+        case 't':
+            *codepoint = '\t';
+            return 2;
+        case '\"':
+        case '\\':
+        case '/':
+            *codepoint = input[1];
+            return 2;
+        /* UTF-16 literal */
+        case 'u':
+            sequence_length = PARSER(parse_utf16_literal)(input, input_end, codepoint);
+            if (sequence_length == 0) {
+                *error = STRING_INVALID_UTF16;
+            }
+            return sequence_length;
+
+        default:
+            *error = STRING_INVALID_ESCAPE;
+            return 0;
+    }
+}
+
+/* write the ASCII run at input into the result string of the given kind, starting at index */
+static inline void PARSER(write_ascii_run)(int kind, void *data, Py_ssize_t index, const CHAR_T *input, Py_ssize_t length) {
+    Py_ssize_t i;
+
+    switch (kind) {
+        case PyUnicode_1BYTE_KIND:
+#if CHAR_SIZE == 1
+            memcpy((Py_UCS1 *) data + index, input, (size_t) length);
+#else
+            for (i = 0; i < length; i++) {
+                ((Py_UCS1 *) data)[index + i] = (Py_UCS1) input[i];
+            }
+#endif
+            break;
+        case PyUnicode_2BYTE_KIND:
+            for (i = 0; i < length; i++) {
+                ((Py_UCS2 *) data)[index + i] = (Py_UCS2) input[i];
+            }
+            break;
+        default:
+            for (i = 0; i < length; i++) {
+                ((Py_UCS4 *) data)[index + i] = (Py_UCS4) input[i];
+            }
+            break;
+    }
+}
+
+/* First pass over the characters of a string: validate them, and add the length and the widest character of the
+ * result to output_length and maxchar. It starts at input_pointer and leaves it at the closing quote, or at the
+ * invalid sequence. It does not need the GIL. */
+static inline string_error PARSER(measure_string)(const CHAR_T **input_pointer, const CHAR_T *const input_end, Py_ssize_t *output_length, Py_UCS4 *maxchar) {
+    const CHAR_T *pointer = *input_pointer;
+    Py_ssize_t length = *output_length;
+    Py_ssize_t run_length = 0;
+    Py_UCS4 codepoint = 0;
+    string_error error = STRING_VALID;
+
+    for (;;) {
+        Py_ssize_t sequence_length;
+
+        if (pointer >= input_end) {
+            error = STRING_UNTERMINATED;
+            break; /* string ended unexpectedly */
+        }
+        if (*pointer == '\"') {
+            break;
+        }
+#if DECODE_UTF8 && defined(PYCJSON_USE_SSE2)
+        if (*pointer != '\\') {
+            /* whole blocks of raw characters are validated and measured at once */
+            run_length = validate_utf8_run(pointer, input_end, &length, maxchar);
+            if (run_length > 0) {
+                pointer += run_length;
+                continue;
+            }
+        }
+#endif
+        if ((*pointer < 0x80) && (*pointer != '\\')) {
+            run_length = scan_string_plain(pointer, input_end);
+            pointer += run_length;
+            length += run_length;
+            continue;
+        }
+        sequence_length = PARSER(decode_special)(pointer, input_end, &codepoint, &error);
+        if (sequence_length == 0) {
+            break;
+        }
+        if (codepoint > *maxchar) {
+            *maxchar = codepoint;
+        }
+        pointer += sequence_length;
+        length++;
+    }
+
+    *input_pointer = pointer;
+    *output_length = length;
+    return error;
+}
+
+/* Second pass: write the characters of the string between input and input_end, which the first pass validated,
+ * into the result string of the given kind. */
+static void PARSER(write_string)(int kind, void *data, const CHAR_T *input, const CHAR_T *const input_end) {
+    Py_ssize_t index = 0;
+    Py_ssize_t run_length = 0;
+    Py_UCS4 codepoint = 0;
+    string_error error = STRING_VALID;
+
+    while (input < input_end) {
+        if ((*input < 0x80) && (*input != '\\')) {
+            run_length = scan_string_plain(input, input_end);
+            PARSER(write_ascii_run)(kind, data, index, input, run_length);
+            input += run_length;
+            index += run_length;
+            continue;
+        }
+#if DECODE_UTF8
+        /* the sequences were validated by the first pass */
+        if (*input != '\\') {
+            input += decode_utf8_unchecked(input, &codepoint);
+        } else {
+            input += PARSER(decode_special)(input, input_end, &codepoint, &error);
+        }
+#else
+        input += PARSER(decode_special)(input, input_end, &codepoint, &error);
+#endif
+        PyUnicode_WRITE(kind, data, index, codepoint);
+        index++;
+    }
+}
+
+/* set the error for the string at the offset of input_buffer, with the invalid sequence at input_pointer */
+static void PARSER(raise_string_error)(const parse_buffer *const input_buffer, string_error error, const CHAR_T *const input_pointer) {
+    switch (error) {
+        case STRING_UNTERMINATED:
+            PyErr_Format(PyExc_ValueError, "Failed to parse string: string ended unexpectedly\nposition: %zd", error_position(input_buffer));
+            break;
+        case STRING_BACKSLASH_AT_END:
+            PyErr_Format(PyExc_ValueError, "Failed to parse string: buffer overflow\nposition: %zd", error_position(input_buffer));
+            break;
+        case STRING_INVALID_UTF16:
+            PyErr_Format(PyExc_ValueError, "Failed to parse string: invalid UTF-16\nposition: %zd", error_position(input_buffer));
+            break;
+        case STRING_INVALID_ESCAPE:
+            PyErr_Format(PyExc_ValueError, "Failed to parse string: invalid escape sequence(%d)\nposition: %zd", (int) input_pointer[1], error_position(input_buffer));
+            break;
+        default:
+            PyErr_Format(PyExc_ValueError, "Failed to parse string: invalid UTF-8\nposition: %zd", input_buffer->origin + (Py_ssize_t) (input_pointer - (const CHAR_T *) input_buffer->content));
+            break;
+    }
+}
+
+/* Parse the input text into an unescaped cinput, and populate item. */
+static bool PARSER(parse_string)(PyObject **item, parse_buffer *const input_buffer) {
+    assert(item);
+    const CHAR_T *const input_start = buffer_at_offset(input_buffer) + 1;
+    const CHAR_T *const input_end = buffer_end(input_buffer);
+    const CHAR_T *input_pointer = input_start;
+    Py_ssize_t output_length = 0;
+    Py_UCS4 maxchar = 127;
+    string_error error;
+
+    /* not a string */
+    if (buffer_at_offset(input_buffer)[0] != '\"') {
+        PyErr_Format(PyExc_ValueError, "Failed to parse string: it is not a string\nposition: %zd", error_position(input_buffer));
+        goto fail;
+    }
+
+    /* fast path: pure ASCII without escape sequences is copied straight into the result */
+    input_pointer += scan_string_plain(input_pointer, input_end);
+    if ((input_pointer < input_end) && (*input_pointer == '\"')) {
+        *item = PyUnicode_New(input_pointer - input_start, 127);
+        if (*item == NULL) {
+            PyErr_Format(PyExc_MemoryError, "Failed to parse string: allocation failure\nposition: %zd", error_position(input_buffer));
+            goto fail; /* allocation failure */
+        }
+        PARSER(write_ascii_run)(PyUnicode_1BYTE_KIND, PyUnicode_1BYTE_DATA(*item), 0, input_start, input_pointer - input_start);
+        goto success;
+    }
+
+#if !DECODE_UTF8
+    /* every character is a code point already, a string without escape sequences is created from the input */
+    input_pointer += scan_string_special(input_pointer, input_end);
+    if ((input_pointer < input_end) && (*input_pointer == '\"')) {
+        /* the values of the kinds are the sizes of their characters */
+        *item = PyUnicode_FromKindAndData(CHAR_SIZE, input_start, input_pointer - input_start);
+        if (*item == NULL) {
+            goto fail;
+        }
+        goto success;
+    }
+    input_pointer = input_start + scan_string_plain(input_start, input_end);
+#endif
+
+    /* first pass: validate, and measure the length and the widest character of the result */
+    output_length = input_pointer - input_start;
+    error = PARSER(measure_string)(&input_pointer, input_end, &output_length, &maxchar);
+    if (error != STRING_VALID) {
+        PARSER(raise_string_error)(input_buffer, error, input_pointer);
+        goto fail;
+    }
+
+    /* second pass: write the code units straight into a string of the right kind */
+    *item = PyUnicode_New(output_length, maxchar);
+    if (*item == NULL) {
+        goto fail;
+    }
+    PARSER(write_string)(PyUnicode_KIND(*item), PyUnicode_DATA(*item), input_start, input_pointer);
+
+success:
+    /* skip the closing quote */
+    input_buffer->offset = (Py_ssize_t) (input_pointer - (const CHAR_T *) input_buffer->content) + 1;
+
+    return true;
+
+fail:
+    input_buffer->offset = (Py_ssize_t) (input_pointer - (const CHAR_T *) input_buffer->content);
+
+    return false;
+}
+
+/* Parse the input text to generate a number, and populate the result into item. */
+static bool PARSER(parse_number)(PyObject **item, parse_buffer *const input_buffer) {
+#if CHAR_SIZE == 1
+    return parse_number_ascii(item, input_buffer, buffer_at_offset(input_buffer), buffer_end(input_buffer));
+#else
+    {
+        /* numbers are ASCII, so the characters that can belong to one are narrowed to bytes first */
+        const CHAR_T *const starting_point = buffer_at_offset(input_buffer);
+        const CHAR_T *const input_end = buffer_end(input_buffer);
+        unsigned char stack_buffer[64] = {0};
+        unsigned char *narrow = stack_buffer;
+        Py_ssize_t i = 0;
+        bool result = false;
+
+        while ((starting_point + i < input_end) && is_number_char(starting_point[i])) {
+            i++;
+        }
+        if (i > (Py_ssize_t) sizeof(stack_buffer)) {
+            narrow = (unsigned char *) input_buffer->hooks.allocate((size_t) i);
+            if (narrow == NULL) {
+                PyErr_Format(PyExc_MemoryError, "Failed to parse number: allocation failure\nposition: %zd", error_position(input_buffer));
+                return false;
+            }
+        }
+        for (Py_ssize_t j = 0; j < i; j++) {
+            narrow[j] = (unsigned char) starting_point[j];
+        }
+        result = parse_number_ascii(item, input_buffer, narrow, narrow + i);
+        if (narrow != stack_buffer) {
+            input_buffer->hooks.deallocate(narrow);
+        }
+        return result;
+    }
+#endif
+}
+
+/* Parse an object key. Short keys without escape sequences are looked up by their raw characters,
+ * so a key that repeats across the records of one document is created only once. */
+static bool PARSER(parse_object_key)(PyObject **item, parse_buffer *const input_buffer) {
+    const CHAR_T *const input_start = buffer_at_offset(input_buffer) + 1;
+    const CHAR_T *const input_end = buffer_end(input_buffer);
+    key_cache_entry *entry = NULL;
+    Py_ssize_t raw_length = 0;
+    Py_ssize_t i;
+    size_t hash = 2166136261u;
+
+    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '\"')) {
+        return PARSER(parse_string)(item, input_buffer);
+    }
+    raw_length = scan_string_special(input_start, input_end);
+    if ((raw_length > KEY_CACHE_MAX_KEY_LENGTH) || (input_start + raw_length >= input_end) || (input_start[raw_length] != '\"')) {
+        /* escaped, long and unterminated keys are not cached */
+        return PARSER(parse_string)(item, input_buffer);
+    }
+
+    if (!ensure_key_cache(input_buffer)) {
+        return false;
+    }
+
+    /* FNV-1a */
+    for (i = 0; i < raw_length; i++) {
+        hash = (hash ^ input_start[i]) * 16777619u;
+    }
+    entry = &input_buffer->key_cache[hash & (KEY_CACHE_SIZE - 1)];
+    if ((entry->key != NULL) && (entry->raw_length == raw_length) && (memcmp(entry->raw, input_start, (size_t) raw_length * CHAR_SIZE) == 0)) {
+        Py_INCREF(entry->key);
+        *item = entry->key;
+        input_buffer->offset += raw_length + 2;
+        return true;
+    }
+
+    if (!PARSER(parse_string)(item, input_buffer)) {
+        return false;
+    }
+    /* the slot is direct-mapped, a colliding key simply replaces the previous one */
+    Py_XDECREF(entry->key);
+    Py_INCREF(*item);
+    entry->key = *item;
+    entry->raw = input_start;
+    entry->raw_length = raw_length;
+
+    return true;
+}
+
+/* check if the input at pointer continues with the given ASCII literal
+ * For bytes the length is a constant after inlining, so the memcmp becomes one or two word compares. */
+static inline bool PARSER(match_at)(const CHAR_T *const pointer, const CHAR_T *const end, const char *const literal, Py_ssize_t length) {
+#if CHAR_SIZE == 1
+    return ((end - pointer) >= length) && (memcmp(pointer, literal, (size_t) length) == 0);
+#else
+    Py_ssize_t i;
+
+    if ((end - pointer) < length) {
+        return false;
+    }
+    for (i = 0; i < length; i++) {
+        if (pointer[i] != (unsigned char) literal[i]) {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
+
+static inline bool PARSER(match_literal)(const parse_buffer *const input_buffer, const char *const literal, Py_ssize_t length) {
+    return PARSER(match_at)(buffer_at_offset(input_buffer), buffer_end(input_buffer), literal, length);
+}
+
+/* Parse a string, number or literal. */
+static inline bool PARSER(parse_scalar)(PyObject **item, parse_buffer *const input_buffer) {
+    /* parse the different types of values, dispatching on the first character */
+    switch (buffer_at_offset(input_buffer)[0]) {
+        /* string */
+        case '\"':
+            return PARSER(parse_string)(item, input_buffer);
+        /* number */
+        case '-':
+            /* -Infinity */
+            if (PARSER(match_literal)(input_buffer, "-Infinity", 9)) {
+                *item = PyFloat_FromDouble(-INFINITY);
+                input_buffer->offset += 9;
+                return true;
+            }
+            return PARSER(parse_number)(item, input_buffer);
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+            return PARSER(parse_number)(item, input_buffer);
+        /* null */
+        case 'n':
+            if (PARSER(match_literal)(input_buffer, "null", 4)) {
+                Py_INCREF(Py_None);
+                *item = Py_None;
+                input_buffer->offset += 4;
+                return true;
+            }
+            break;
+        /* false */
+        case 'f':
+            if (PARSER(match_literal)(input_buffer, "false", 5)) {
+                Py_INCREF(Py_False);
+                *item = Py_False;
+                input_buffer->offset += 5;
+                return true;
+            }
+            break;
+        /* true */
+        case 't':
+            if (PARSER(match_literal)(input_buffer, "true", 4)) {
+                Py_INCREF(Py_True);
+                *item = Py_True;
+                input_buffer->offset += 4;
+                return true;
+            }
+            break;
+        /* Infinity */
+        case 'I':
+            if (PARSER(match_literal)(input_buffer, "Infinity", 8)) {
+                *item = PyFloat_FromDouble(INFINITY);
+                input_buffer->offset += 8;
+                return true;
+            }
+            break;
+        /* NaN */
+        case 'N':
+            if (PARSER(match_literal)(input_buffer, "NaN", 3)) {
+                *item = PyFloat_FromDouble(Py_NAN);
+                input_buffer->offset += 3;
+                return true;
+            }
+            break;
+        default:
+            break;
+    }
+
+    PyErr_Format(PyExc_ValueError, "Failed to parse value: invalid value\nposition: %zd", error_position(input_buffer));
+
+    return false;
+}
+
+/* check the string whose opening quote is at *pointer as parse_string does, leaving *pointer after its closing quote */
+static bool PARSER(validate_string)(const CHAR_T *const content, const CHAR_T **pointer, const CHAR_T *const end, validate_error *const error) {
+    const CHAR_T *const input_start = *pointer + 1;
+    const CHAR_T *input_pointer = input_start + scan_string_plain(input_start, end);
+    Py_ssize_t output_length = 0;
+    Py_UCS4 maxchar = 127;
+
+    if ((input_pointer >= end) || (*input_pointer != '\"')) {
+        switch (PARSER(measure_string)(&input_pointer, end, &output_length, &maxchar)) {
+            case STRING_VALID:
+                break;
+            case STRING_UNTERMINATED:
+                return validate_fail(error, "Failed to parse string: string ended unexpectedly", *pointer - content);
+            case STRING_BACKSLASH_AT_END:
+                return validate_fail(error, "Failed to parse string: buffer overflow", *pointer - content);
+            case STRING_INVALID_UTF16:
+                return validate_fail(error, "Failed to parse string: invalid UTF-16", *pointer - content);
+            case STRING_INVALID_ESCAPE:
+                error->arguments[0] = (int) input_pointer[1];
+                return validate_fail(error, "Failed to parse string: invalid escape sequence(%d)", *pointer - content);
+            default:
+                return validate_fail(error, "Failed to parse string: invalid UTF-8", input_pointer - content);
+        }
+    }
+    *pointer = input_pointer + 1;
+    return true;
+}
+
+/* Check the number at *pointer as parse_number does, leaving *pointer after it. max_digits is the limit of int on the
+ * digits of a string, 0 for none. Returns false with error->message NULL if out of memory. */
+static bool PARSER(validate_number)(const CHAR_T *const content, const CHAR_T **pointer, const CHAR_T *const end, Py_ssize_t max_digits, validate_error *const error) {
+    const CHAR_T *const start = *pointer;
+    long long integer = 0;
+    double number = 0.0;
+    Py_ssize_t length = 0;
+    int processed = 0;
+    bool valid = true;
+#if CHAR_SIZE == 1
+    const unsigned char *const narrow = start;
+    const unsigned char *const narrow_end = end;
+#else
+    /* numbers are ASCII, so the characters that can belong to one are narrowed to bytes first */
+    unsigned char stack_buffer[64] = {0};
+    unsigned char *narrow = stack_buffer;
+    const unsigned char *narrow_end = NULL;
+    Py_ssize_t i = 0;
+
+    while ((start + i < end) && is_number_char(start[i])) {
+        i++;
+    }
+    if (i > (Py_ssize_t) sizeof(stack_buffer)) {
+        narrow = (unsigned char *) PyMem_RawMalloc((size_t) i);
+        if (narrow == NULL) {
+            return false;
+        }
+    }
+    for (Py_ssize_t j = 0; j < i; j++) {
+        narrow[j] = (unsigned char) start[j];
+    }
+    narrow_end = narrow + i;
+#endif
+
+    if (parse_number_fast(narrow, narrow_end, &integer, &number, &length) == NUMBER_OTHER) {
+        valid = check_number_run(narrow, narrow_end, &length, &processed);
+        /* PyLong_FromString refuses integers with more digits than the limit */
+        if (valid && (processed < 0) && (max_digits > 0) && ((length - (narrow[0] == '-')) > max_digits)) {
+            valid = false;
+        }
+    }
+#if CHAR_SIZE > 1
+    if (narrow != stack_buffer) {
+        PyMem_RawFree(narrow);
+    }
+#endif
+    if (!valid) {
+        if (processed >= 0) {
+            error->arguments[0] = processed;
+            error->arguments[1] = (int) length;
+            return validate_fail(error, "Failed to parse number: invalid number, only can parse (%d/%d)", start - content);
+        }
+        return validate_fail(error, "Failed to parse number: invalid number", start - content);
+    }
+    *pointer = start + length;
+    return true;
+}
+
+/* check the string, number or literal at *pointer as parse_scalar does */
+static bool PARSER(validate_scalar)(const CHAR_T *const content, const CHAR_T **pointer, const CHAR_T *const end, Py_ssize_t max_digits, validate_error *const error) {
+    const CHAR_T *const start = *pointer;
+
+    switch (*start) {
+        case '\"':
+            return PARSER(validate_string)(content, pointer, end, error);
+        case '-':
+            if (PARSER(match_at)(start, end, "-Infinity", 9)) {
+                *pointer = start + 9;
+                return true;
+            }
+            return PARSER(validate_number)(content, pointer, end, max_digits, error);
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+            return PARSER(validate_number)(content, pointer, end, max_digits, error);
+        case 'n':
+            if (PARSER(match_at)(start, end, "null", 4)) {
+                *pointer = start + 4;
+                return true;
+            }
+            break;
+        case 'f':
+            if (PARSER(match_at)(start, end, "false", 5)) {
+                *pointer = start + 5;
+                return true;
+            }
+            break;
+        case 't':
+            if (PARSER(match_at)(start, end, "true", 4)) {
+                *pointer = start + 4;
+                return true;
+            }
+            break;
+        case 'I':
+            if (PARSER(match_at)(start, end, "Infinity", 8)) {
+                *pointer = start + 8;
+                return true;
+            }
+            break;
+        case 'N':
+            if (PARSER(match_at)(start, end, "NaN", 3)) {
+                *pointer = start + 3;
+                return true;
+            }
+            break;
+        default:
+            break;
+    }
+    return validate_fail(error, "Failed to parse value: invalid value", start - content);
+}
+
+/* Check the value at *pointer with the grammar and the errors of parse_value, leaving *pointer after it. Nothing is
+ * created and the GIL is not needed, the containers are only tracked by kind. max_depth is how many containers may
+ * still be opened. Returns false with error set if it is invalid, or with error->message NULL if out of memory. */
+static bool PARSER(check_value)(const CHAR_T *const content, const CHAR_T **const value, const CHAR_T *const end, Py_ssize_t max_depth, Py_ssize_t max_digits, validate_error *const error) {
+    const CHAR_T *pointer = *value;
+    bool local_stack[CONTAINER_STACK_SIZE];
+    bool *is_object = local_stack; /* the kinds of the open containers */
+    Py_ssize_t capacity = CONTAINER_STACK_SIZE;
+    Py_ssize_t depth = 0;
+    parse_state state = STATE_VALUE;
+    bool valid = false;
+
+    for (;;) {
+        switch (state) {
+            case STATE_VALUE:
+                if (pointer >= end) {
+                    validate_fail(error, "Failed to parse value: invalid value", pointer - content);
+                    goto cleanup;
+                }
+                if ((*pointer == '[') || (*pointer == '{')) {
+                    const bool object = (*pointer == '{');
+
+                    if (depth >= max_depth) {
+                        validate_fail(error, object ? "Failed to parse dictionary: too deeply nested" : "Failed to parse array: too deeply nested", pointer - content);
+                        goto cleanup;
+                    }
+                    if (depth == capacity) {
+                        bool *new_stack = (bool *) PyMem_RawMalloc((size_t) capacity * 2 * sizeof(bool));
+                        if (new_stack == NULL) {
+                            goto cleanup;
+                        }
+                        memcpy(new_stack, is_object, (size_t) depth * sizeof(bool));
+                        if (is_object != local_stack) {
+                            PyMem_RawFree(is_object);
+                        }
+                        is_object = new_stack;
+                        capacity *= 2;
+                    }
+                    is_object[depth++] = object;
+                    pointer = PARSER(skip_whitespace)(pointer + 1, end);
+                    state = object ? STATE_OBJECT_START : STATE_ARRAY_START;
+                    continue;
+                }
+                if (!PARSER(validate_scalar)(content, &pointer, end, max_digits, error)) {
+                    goto cleanup;
+                }
+                break;
+
+            case STATE_ARRAY_START:
+            case STATE_OBJECT_START:
+                if ((pointer < end) && (*pointer == ((state == STATE_OBJECT_START) ? '}' : ']'))) {
+                    /* empty array or object */
+                    pointer++;
+                    depth--;
+                    break;
+                }
+                if (pointer >= end) {
+                    validate_fail(error, (state == STATE_OBJECT_START) ? "Failed to parse dictionary: buffer overflow" : "Failed to parse array: buffer overflow", pointer - 1 - content);
+                    goto cleanup;
+                }
+                state = (state == STATE_OBJECT_START) ? STATE_KEY : STATE_VALUE;
+                continue;
+
+            case STATE_KEY:
+                if ((pointer >= end) || (*pointer != '\"')) {
+                    validate_fail(error, "Failed to parse string: it is not a string", pointer - content);
+                    goto cleanup;
+                }
+                if (!PARSER(validate_string)(content, &pointer, end, error)) {
+                    goto cleanup;
+                }
+                pointer = PARSER(skip_whitespace)(pointer, end);
+                state = STATE_COLON;
+                continue;
+
+            case STATE_COLON:
+                if ((pointer >= end) || (*pointer != ':')) {
+                    validate_fail(error, "Failed to parse dictionary: expected colon", pointer - content);
+                    goto cleanup;
+                }
+                pointer = PARSER(skip_whitespace)(pointer + 1, end);
+                state = STATE_VALUE;
+                continue;
+
+            case STATE_NEXT:
+                if ((pointer < end) && (*pointer == ',')) {
+                    pointer = PARSER(skip_whitespace)(pointer + 1, end);
+                    state = is_object[depth - 1] ? STATE_KEY : STATE_VALUE;
+                    continue;
+                }
+                if ((pointer >= end) || (*pointer != (is_object[depth - 1] ? '}' : ']'))) {
+                    validate_fail(error, is_object[depth - 1] ? "Failed to parse dictionary: expected end of object" : "Failed to parse array: expected end of array", pointer - content);
+                    goto cleanup;
+                }
+                pointer++;
+                depth--;
+                break;
+        }
+
+        /* a value is complete */
+        if (depth == 0) {
+            valid = true;
+            goto cleanup;
+        }
+        pointer = PARSER(skip_whitespace)(pointer, end);
+        state = STATE_NEXT;
+    }
+
+cleanup:
+    if (is_object != local_stack) {
+        PyMem_RawFree(is_object);
+    }
+    *value = pointer;
+    return valid;
+}
+
+/* Skip the value at offset with the checks of parse_value, for the members a projection leaves out. */
+static bool PARSER(skip_value)(parse_buffer *const input_buffer) {
+    const CHAR_T *const content = (const CHAR_T *) input_buffer->content;
+    const CHAR_T *pointer = buffer_at_offset(input_buffer);
+    validate_error error = {NULL, {0, 0}, 0, false, 0, 0};
+
+    if ((input_buffer->max_digits < 0) && ((input_buffer->max_digits = int_max_str_digits()) < 0)) {
+        return false;
+    }
+    if (!PARSER(check_value)(content, &pointer, buffer_end(input_buffer), input_buffer->max_depth - input_buffer->depth, input_buffer->max_digits, &error)) {
+        raise_validate_error(&error, input_buffer->origin);
+        return false;
+    }
+    input_buffer->offset = (Py_ssize_t) (pointer - content);
+    return true;
+}
+
+/* In incremental parsing, check if the token the state expects at offset may continue past the end of the window.
+ * Strings are searched for their closing quote from where the search of the previous window stopped, so a long
+ * string arriving in many windows is searched only once. */
+static bool PARSER(token_incomplete)(parse_buffer *const input_buffer, parse_state state) {
+    const CHAR_T *const input_end = buffer_end(input_buffer);
+    const CHAR_T *input_pointer = buffer_at_offset(input_buffer);
+
+    /* whitespace is only left at the offset when it runs to the end */
+    if (cannot_access_at_index(input_buffer, 0) || (*input_pointer <= 32)) {
+        return true;
+    }
+    if ((state != STATE_VALUE) && (state != STATE_KEY)) {
+        /* brackets, colons and commas are single characters */
+        return false;
+    }
+
+    if (*input_pointer == '\"') {
+        input_pointer = (const CHAR_T *) input_buffer->content + ((input_buffer->scanned > input_buffer->offset) ? input_buffer->scanned : input_buffer->offset + 1);
+        for (;;) {
+            input_pointer += scan_string_special(input_pointer, input_end);
+            if ((input_pointer >= input_end) || ((*input_pointer == '\\') && (input_end - input_pointer < 2))) {
+                /* resume at the backslash, the character it escapes is not there yet */
+                input_buffer->scanned = (Py_ssize_t) (input_pointer - (const CHAR_T *) input_buffer->content);
+                return true;
+            }
+            if (*input_pointer == '\"') {
+                input_buffer->scanned = 0;
+                return false;
+            }
+            input_pointer += 2;
+        }
+    }
+
+    /* numbers and literals end at the first character that cannot belong to one */
+    while ((input_pointer < input_end) && (is_number_char(*input_pointer) || ((*input_pointer >= 'a') && (*input_pointer <= 'z')) || ((*input_pointer >= 'A') && (*input_pointer <= 'Z')))) {
+        input_pointer++;
+    }
+    return input_pointer == input_end;
+}
+
+/* Parser core - when encountering text, process appropriately.
+ * Arrays and objects are not parsed recursively: the parser is a loop over states, the open containers are kept on
+ * a stack in the buffer and their children on the value stack. Only max_depth limits the nesting, not the C stack.
+ * Parsing continues in the state left in the buffer. In incremental parsing false is also returned, without an
+ * error set, when the window ends before the value does; the next call resumes at the token that was cut off. */
+static bool PARSER(parse_value)(PyObject **item, parse_buffer *const input_buffer) {
+    assert(item);
+    PyObject *value = NULL;
+    /* kept in locals in the loop, the buffer gets the state back when the loop is left */
+    parse_state state = input_buffer->state;
+    bool in_object = (input_buffer->depth > 0) && input_buffer->containers[input_buffer->depth - 1].is_object;
+    bool skip_member = false; /* the projection leaves out the member whose key was parsed */
+
+    for (;;) {
+        if (input_buffer->partial && PARSER(token_incomplete)(input_buffer, state)) {
+            goto incomplete;
+        }
+        switch (state) {
+            case STATE_VALUE:
+                if (cannot_access_at_index(input_buffer, 0)) {
+                    PyErr_Format(PyExc_ValueError, "Failed to parse value: invalid value\nposition: %zd", error_position(input_buffer));
+                    goto fail; /* no input */
+                }
+                if ((buffer_at_offset(input_buffer)[0] == '[') || (buffer_at_offset(input_buffer)[0] == '{')) {
+                    const bool is_object = (buffer_at_offset(input_buffer)[0] == '{');
+                    if (!open_container(input_buffer, is_object)) {
+                        goto fail;
+                    }
+                    input_buffer->offset++;
+                    PARSER(buffer_skip_whitespace)(input_buffer);
+                    in_object = is_object;
+                    state = is_object ? STATE_OBJECT_START : STATE_ARRAY_START;
+                    continue;
+                }
+                if (!PARSER(parse_scalar)(&value, input_buffer)) {
+                    goto fail;
+                }
+                break;
+
+            case STATE_ARRAY_START:
+            case STATE_OBJECT_START:
+                if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ((state == STATE_OBJECT_START) ? '}' : ']'))) {
+                    /* empty array or object */
+                    input_buffer->offset++;
+                    value = close_container(input_buffer);
+                    if (value == NULL) {
+                        goto fail;
+                    }
+                    break;
+                }
+                /* check if we skipped to the end of the buffer */
+                if (cannot_access_at_index(input_buffer, 0)) {
+                    input_buffer->offset--;
+                    if (state == STATE_OBJECT_START) {
+                        PyErr_Format(PyExc_ValueError, "Failed to parse dictionary: buffer overflow\nposition: %zd", error_position(input_buffer));
+                    } else {
+                        PyErr_Format(PyExc_ValueError, "Failed to parse array: buffer overflow\nposition: %zd", error_position(input_buffer));
+                    }
+                    goto fail;
+                }
+                state = (state == STATE_OBJECT_START) ? STATE_KEY : STATE_VALUE;
+                continue;
+
+            case STATE_KEY:
+                /* parse the name of the child */
+                if (!PARSER(parse_object_key)(&value, input_buffer)) {
+                    goto fail; /* failed to parse name */
+                }
+                if (input_buffer->projection != NULL) {
+                    const int kept = project_member(input_buffer, value);
+                    if (kept < 0) {
+                        goto fail;
+                    }
+                    if (!kept) {
+                        Py_CLEAR(value);
+                        skip_member = true;
+                        PARSER(buffer_skip_whitespace)(input_buffer);
+                        state = STATE_COLON;
+                        continue;
+                    }
+                }
+                if (!push_value(input_buffer, value)) {
+                    value = NULL;
+                    goto fail;
+                }
+                value = NULL;
+                PARSER(buffer_skip_whitespace)(input_buffer);
+                state = STATE_COLON;
+                continue;
+
+            case STATE_COLON:
+                if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':')) {
+                    PyErr_Format(PyExc_ValueError, "Failed to parse dictionary: expected colon\nposition: %zd", error_position(input_buffer));
+                    goto fail; /* invalid object */
+                }
+                input_buffer->offset++;
+                PARSER(buffer_skip_whitespace)(input_buffer);
+                if (skip_member) {
+                    /* the value is checked, nothing of it is created */
+                    skip_member = false;
+                    if (!PARSER(skip_value)(input_buffer)) {
+                        goto fail;
+                    }
+                    PARSER(buffer_skip_whitespace)(input_buffer);
+                    state = STATE_NEXT;
+                    continue;
+                }
+                state = STATE_VALUE;
+                continue;
+
+            case STATE_NEXT:
+                if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ',')) {
+                    input_buffer->offset++;
+                    PARSER(buffer_skip_whitespace)(input_buffer);
+                    state = in_object ? STATE_KEY : STATE_VALUE;
+                    continue;
+                }
+                if (in_object && (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '}'))) {
+                    PyErr_Format(PyExc_ValueError, "Failed to parse dictionary: expected end of object\nposition: %zd", error_position(input_buffer));
+                    goto fail; /* expected end of object */
+                }
+                if (!in_object && (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ']'))) {
+                    PyErr_Format(PyExc_ValueError, "Failed to parse array: expected end of array\nposition: %zd", error_position(input_buffer));
+                    goto fail; /* expected end of array */
+                }
+                input_buffer->offset++;
+                value = close_container(input_buffer);
+                if (value == NULL) {
+                    goto fail;
+                }
+                break;
+        }
+
+        /* a value is complete, it is the result or a child of the innermost open container */
+        if (input_buffer->depth == 0) {
+            input_buffer->state = STATE_VALUE;
+            *item = value;
+            return true;
+        }
+        in_object = input_buffer->containers[input_buffer->depth - 1].is_object;
+        if (!push_value(input_buffer, value)) {
+            value = NULL;
+            goto fail;
+        }
+        value = NULL;
+        PARSER(buffer_skip_whitespace)(input_buffer);
+        if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ',')) {
+            /* another child follows, the common case skips the round through STATE_NEXT */
+            input_buffer->offset++;
+            PARSER(buffer_skip_whitespace)(input_buffer);
+            state = in_object ? STATE_KEY : STATE_VALUE;
+            continue;
+        }
+        state = STATE_NEXT;
+    }
+
+incomplete:
+    /* the open containers and their children stay on the stacks until the next window */
+    input_buffer->state = state;
+
+    return false;
+
+fail:
+    input_buffer->state = state;
+    Py_XDECREF(value);
+    pop_values(input_buffer, 0);
+    input_buffer->depth = 0;
+
+    return false;
+}
+
+/* Parse the document in buffer from the state left in it to its end. */
+static PyObject *PARSER(finish_text)(parse_buffer *const buffer) {
+    PyObject *item = NULL;
+
+    if (!PARSER(parse_value)(&item, buffer)) {
+        /* parse failure. ep is set. */
+        goto fail;
+    }
+    if (buffer->offset < buffer->length) {
+        PyErr_Format(PyExc_ValueError, "Failed to parse JSON: extra characters at the end\nend position: %zd", error_position(buffer));
+        goto fail;
+    }
+    return item;
+
+fail:
+    Py_XDECREF(item);
+    if (!PyErr_Occurred()) {
+        Py_ssize_t position = 0;
+
+        if (buffer->offset < buffer->length) {
+            position = buffer->offset;
+        } else if (buffer->length > 0) {
+            position = buffer->length - 1;
+        }
+
+        PyErr_Format(PyExc_ValueError, "Failed to parse JSON (position %zd)", buffer->origin + position);
+    }
+    return NULL;
+}
+
+/* Parse value as one JSON document with the options already set in buffer. The scratch memory of buffer is kept,
+ * so that the key cache is shared by the documents of one input. */
+static PyObject *PARSER(parse_text)(parse_buffer *const buffer, const CHAR_T *value, Py_ssize_t buffer_length) {
+    if (0 == buffer_length) {
+        PyErr_SetString(PyExc_ValueError, "Empty string");
+        return NULL;
+    }
+    buffer->content = value;
+    buffer->length = buffer_length;
+    buffer->offset = 0;
+    buffer->state = STATE_VALUE;
+    PARSER(skip_bom)(buffer);
+    PARSER(buffer_skip_whitespace)(buffer);
+    return PARSER(finish_text)(buffer);
+}
+
+/* Parse the first document from offset start of value on, for raw_decode. Whitespace around it is skipped, whatever
+ * follows that is left alone: *end is set to the offset of it, the length if the input ends in whitespace. The
+ * scratch memory of buffer is released. */
+static PyObject *PARSER(parse_raw)(parse_buffer *const buffer, const CHAR_T *value, Py_ssize_t length, Py_ssize_t start, Py_ssize_t *end) {
+    PyObject *item = NULL;
+
+    buffer->hooks = global_hooks;
+    buffer->content = value;
+    buffer->length = length;
+    buffer->offset = start;
+    buffer->state = STATE_VALUE;
+    PARSER(buffer_skip_whitespace)(buffer);
+    if (PARSER(parse_value)(&item, buffer)) {
+        PARSER(buffer_skip_whitespace)(buffer);
+        if ((buffer->offset == buffer->length - 1) && (buffer_at_offset(buffer)[0] <= 32)) {
+            /* buffer_skip_whitespace stops at the last character */
+            buffer->offset = buffer->length;
+        }
+        *end = buffer->offset;
+    }
+    parse_buffer_free(buffer);
+    return item;
+}
+
+/* Parse value as one JSON document with the options already set in buffer, and release the scratch memory of buffer. */
+static PyObject *PARSER(parse_document)(parse_buffer *const buffer, const CHAR_T *value, Py_ssize_t buffer_length) {
+    PyObject *item = NULL;
+
+    buffer->hooks = global_hooks;
+    item = PARSER(parse_text)(buffer, value, buffer_length);
+    parse_buffer_free(buffer);
+    return item;
+}
+
+/* Parse one line of JSON Lines input, starting at buffer->origin of the whole input.
+ * Whitespace around the document is ignored, a blank line gives NULL without an error set. */
+static PyObject *PARSER(parse_line)(parse_buffer *const buffer, const CHAR_T *line, Py_ssize_t length) {
+    while ((length > 0) && (line[length - 1] <= 32)) {
+        length--;
+    }
+    if (length == 0) {
+        return NULL;
+    }
+    return PARSER(parse_text)(buffer, line, length);
+}
+
+/* Parse every line of value and append the documents to list, handling invalid lines as errors says. */
+static bool PARSER(parse_lines)(parse_buffer *const buffer, const CHAR_T *value, Py_ssize_t length, line_errors errors, PyObject *list) {
+    Py_ssize_t start = 0;
+    Py_ssize_t lineno = 0;
+
+    while (start < length) {
+        Py_ssize_t end = start;
+        PyObject *item = NULL;
+
+#if CHAR_SIZE == 1
+        {
+            const CHAR_T *newline = (const CHAR_T *) memchr(value + start, '\n', (size_t) (length - start));
+            end = (newline == NULL) ? length : (Py_ssize_t) (newline - value);
+        }
+#else
+        while ((end < length) && (value[end] != '\n')) {
+            end++;
+        }
+#endif
+        lineno++;
+        buffer->origin = start;
+        item = PARSER(parse_line)(buffer, value + start, end - start);
+        start = end + 1;
+        if (item == NULL) {
+            if (PyErr_Occurred() && !handle_line_error(errors, lineno, &item)) {
+                return false;
+            }
+            if (item == NULL) {
+                continue; /* a blank or skipped line */
+            }
+        }
+        if (PyList_Append(list, item) < 0) {
+            Py_DECREF(item);
+            return false;
+        }
+        Py_DECREF(item);
+    }
+    return true;
+}
+
+/* Check a whole document with the grammar and the errors of parse_text, without the GIL and without creating
+ * anything. Returns false with error set if it is invalid, or with error->message NULL if out of memory. */
+static bool PARSER(validate_document)(const CHAR_T *const content, Py_ssize_t length, Py_ssize_t max_depth, Py_ssize_t max_digits, validate_error *const error) {
+    const CHAR_T *const end = content + length;
+    const CHAR_T *pointer = content;
+
+    if (length == 0) {
+        return validate_fail(error, "Empty string", 0);
+    }
+    pointer += PARSER(bom_length)(pointer, end);
+    pointer = PARSER(skip_whitespace)(pointer, end);
+    if (!PARSER(check_value)(content, &pointer, end, max_depth, max_digits, error)) {
+        return false;
+    }
+    if (pointer < end) {
+        error->at_end = true;
+        return validate_fail(error, "Failed to parse JSON: extra characters at the end", pointer - content);
+    }
+    return true;
+}
+
+/* Validate the document for validate, and set the line and column of the error if it is invalid. The column counts
+ * code units as the position does: bytes of bytes-like objects, characters of a str. It does not need the GIL. */
+static bool PARSER(validate_text)(const CHAR_T *const content, Py_ssize_t length, Py_ssize_t max_depth, Py_ssize_t max_digits, validate_error *const error) {
+    const CHAR_T *target = NULL;
+    const CHAR_T *line_start = content;
+    const CHAR_T *pointer = NULL;
+
+    if (PARSER(validate_document)(content, length, max_depth, max_digits, error)) {
+        return true;
+    }
+    if (error->message == NULL) {
+        return false; /* out of memory */
+    }
+    target = content + error->position;
+    error->lineno = 1;
+    for (pointer = content; pointer < target; pointer++) {
+        if (*pointer == '\n') {
+            error->lineno++;
+            line_start = pointer + 1;
+        }
+    }
+    error->colno = (Py_ssize_t) (target - line_start) + 1;
+    return false;
+}
+
+#undef scan_string_plain
+#undef scan_string_special
+#undef buffer_at_offset
+#undef buffer_end
+#undef CHAR_T
+#undef CHAR_SIZE
+#undef DECODE_UTF8
+#undef PARSER
@@ -12,7 +12,8 @@ class TestDecode(unittest.TestCase):
         import cjson
 
         test_cases = {
-            ValueError: ["0xf", "{\"a\":}", "[1,2,3", "\"111\"]", "{\"a\": 1 2}"],
+            ValueError: ["0xf", "{\"a\":}", "[1,2,3", "\"111\"]", "{\"a\": 1 2}", "[[1, 2], [3, 4", "[1, [2, [3, x]]]",
+                         "nul", "[tru]", "fals", "Infinit", "-Infinit", "NaX"],
             # OverflowError: ["1e500"]
         }
         for err, cases in test_cases.items():
@@ -21,6 +22,458 @@ class TestDecode(unittest.TestCase):
                     with self.assertRaises(err):
                         cjson.loads(case)
 
+    def test_whitespace(self):
+        import json
+
+        import cjson
+
+        for n in range(40):
+            ws = (" \t\r\n" * 10)[:n]
+            case = f'{ws}[{ws}1{ws},{ws}{{{ws}"a"{ws}:{ws}"b c"{ws}}}{ws},{ws}[{ws}]{ws}]'
+            with self.subTest(msg=f'decoding_whitespace_test(n={n})'):
+                self._check_obj_same(cjson.loads(case), json.loads(case))
+
+    def test_string(self):
+        import json
+
+        import cjson
+
+        test_cases = [
+            '""',
+            '"\\b\\f\\n\\r\\t\\"\\\\\\/"',
+            '"a\\u0000b"',
+            '"\\u00e9\\u20ac\\ud83d\\ude80"',
+            '"é€🚀\\nabc"',
+        ]
+        for n in (15, 16, 17, 511, 512, 513, 2000):
+            test_cases.append('"' + "a" * n + '"')
+            test_cases.append('"' + "a" * n + '\\n' + "é" * n + '"')
+        for case in test_cases:
+            with self.subTest(msg=f'decoding_string_test(case={case})'):
+                self._check_obj_same(cjson.loads(case), json.loads(case))
+                self._check_obj_same(cjson.loads(case.encode()), json.loads(case))
+        for case in ['"abc', '"\\', '"\\x"', '"\\u12"', '"\\uZZZZ"']:
+            with self.subTest(msg=f'decoding_string_fail_test(case={case})'):
+                with self.assertRaises(ValueError):
+                    cjson.loads(case)
+        # truncated, overlong, surrogate and out of range sequences
+        for case in [b'"\x80"', b'"\xc3"', b'"\xc0\xaf"', b'"\xe0\x80\xaf"', b'"\xed\xa0\x80"', b'"\xf4\x90\x80\x80"', b'"\xe2\x82\\n"']:
+            with self.subTest(msg=f'decoding_utf8_fail_test(case={case})'):
+                with self.assertRaises(ValueError):
+                    cjson.loads(case)
+        # the position is the one of the first invalid sequence, in short strings and in long ones
+        for prefix in (b'["a", "', b'["a", "' + "é€🚀".encode() * 20 + b"a" * 7):
+            for bad in (b"\xff", b"\xe2\x82", b"\xed\xa0\x80", b"\xc3\xc3\xa9"):
+                case = prefix + bad + b'b' * 40 + b'"]'
+                with self.subTest(msg=f'decoding_utf8_position_test(case={case})'):
+                    with self.assertRaisesRegex(ValueError, f"invalid UTF-8\nposition: {len(prefix)}$"):
+                        cjson.loads(case)
+
+    def test_integer(self):
+        import cjson
+
+        test_cases = [0, -0, 7, -7, 12345678, -87654321, 10 ** 17, 10 ** 18 - 1, -(10 ** 18 - 1), 10 ** 18,
+                      2 ** 63 - 1, -(2 ** 63), 2 ** 64, 10 ** 40, -(10 ** 40)]
+        for value in test_cases:
+            case = f"[{value}, {{\"a\": {value}}}, {value}]"
+            with self.subTest(msg=f'decoding_integer_test(case={case})'):
+                self.assertEqual(cjson.loads(case), [value, {"a": value}, value])
+                self.assertEqual(cjson.loads(str(value)), value)
+
+    def test_float(self):
+        import cjson
+
+        test_cases = ["0.0", "-0.0", "1.5", "-2.5e-3", "1E5", "1e+5", "0.1", "3.141592653589793",
+                      "2.2250738585072011e-308", "2.2250738585072014e-308", "4.9e-324", "2.4703282292062327e-324",
+                      "2.4703282292062328e-324", "1.7976931348623157e308", "1.7976931348623159e308", "1e400",
+                      "1e-400", "9007199254740993.0", "9007199254740993e0", "0.000000000000000000001234",
+                      "123456789012345678901234567890.5", "7.2057594037927933e16", "1448997445238699.0e-4"]
+        for case in test_cases:
+            with self.subTest(msg=f'decoding_float_test(case={case})'):
+                self.assertEqual(repr(cjson.loads(case)), repr(float(case)))
+                self.assertEqual(repr(cjson.loads(f"[{case}]")[0]), repr(float(case)))
+
+    def test_object_keys(self):
+        import json
+
+        import cjson
+
+        keys = ["id", "name", "é", "\\u00e9", "a\\nb", "k" * 100] + [f"key{i}" for i in range(600)]
+        case = "[" + ",".join("{" + ",".join(f'"{k}": {i}' for i, k in enumerate(keys)) + "}" for _ in range(3)) + "]"
+        self._check_obj_same(cjson.loads(case), json.loads(case))
+        case = '{"a": 1, "b": 2, "a": 3}'
+        self._check_obj_same(cjson.loads(case), json.loads(case))
+
+        result = cjson.loads('[{"id": 1, "name": "a"}, {"id": 2, "name": "b"}]')
+        for a, b in zip(result[0], result[1]):
+            self.assertIs(a, b)
+
+    def test_buffer_input(self):
+        import array
+        import json
+
+        import cjson
+
+        case = '[1, 2.5, "abc", {"a": null}]'
+        data = case.encode()
+        for value in (data, bytearray(data), memoryview(data), memoryview(bytearray(b" " + data))[1:], array.array("b", data)):
+            with self.subTest(msg=f'decoding_buffer_test(type={type(value).__name__})'):
+                self._check_obj_same(cjson.loads(value), json.loads(case))
+        buffer = bytearray(data)
+        cjson.loads(buffer)
+        buffer.extend(b" ")  # the buffer has been released
+        with self.assertRaises(TypeError):
+            cjson.loads(1)
+
+    def test_unicode_input(self):
+        import json
+
+        import cjson
+
+        # str is parsed in its own 1, 2 or 4 byte representation, depending on its widest character
+        for wide in ("é", "€", "🚀"):
+            case = (f'{{"{wide}": ["a{wide}", "\\n{wide}\\u00e9\\ud83d\\ude80", 12, -3.5e2, 123456789012345678901234, '
+                    f'{"1" * 80}.5, true, null], "k{wide}": {{"{wide}": "{wide * 600}"}}, "id": "{wide}"}}')
+            with self.subTest(msg=f'decoding_unicode_test(wide={wide})'):
+                self._check_obj_same(cjson.loads(case), json.loads(case))
+                self._check_obj_same(cjson.loads("\ufeff" + case), json.loads(case))
+                result = cjson.loads(f'[{{"{wide}": 1}}, {{"{wide}": 2}}]')
+                self.assertIs(next(iter(result[0])), next(iter(result[1])))
+                # positions count characters, not UTF-8 bytes
+                with self.assertRaisesRegex(ValueError, "position: 6"):
+                    cjson.loads(f'["{wide}", x]')
+        # the byte order mark is skipped the same way however short the document is
+        for case in ("1", "[]", ""):
+            with self.subTest(msg=f'decoding_unicode_test(bom={case!r})'):
+                if case:
+                    self.assertEqual(cjson.loads("\ufeff" + case), json.loads(case))
+                    self.assertEqual(cjson.loads(("\ufeff" + case).encode()), json.loads(case))
+                else:
+                    with self.assertRaisesRegex(ValueError, "position: 1"):
+                        cjson.loads("\ufeff")
+                    with self.assertRaisesRegex(ValueError, "position: 3"):
+                        cjson.loads("\ufeff".encode())
+
+    def test_max_depth(self):
+        import cjson
+
+        self.assertIsInstance(cjson.loads("[" * 1000 + "]" * 1000), list)
+        with self.assertRaisesRegex(ValueError, "too deeply nested"):
+            cjson.loads("[" * 1001 + "]" * 1001)
+        with self.assertRaisesRegex(ValueError, "too deeply nested"):
+            cjson.loads('{"a": [{"b": 1}]}', max_depth=2)
+        self.assertEqual(cjson.loads('{"a": [{"b": 1}]}', max_depth=3), {"a": [{"b": 1}]})
+        self.assertEqual(cjson.loads("1", max_depth=0), 1)
+        with self.assertRaises(ValueError):
+            cjson.loads("1", max_depth=-1)
+
+        # nesting is not limited by the C stack
+        depth = 100000
+        result = cjson.loads(("[" * depth + "]" * depth).encode(), max_depth=depth)
+        for _ in range(depth - 1):
+            result = result[0]
+        self.assertEqual(result, [])
+
+    def test_incremental(self):
+        import json
+
+        import cjson
+
+        test_cases = [
+            '[1, -2.5e-3, 12345678901234567890, "abc", {"a": null, "b": [true, false]}, -Infinity, NaN, "\\u00e9\\n\\"", "é€🚀"]',
+            '{"key": "' + "x" * 3000 + '\\"' + "é" * 100 + '", "n": 123456789}',
+            "12345", '"abc"', "true", "[]", "{}", '[[[{"a": {}}]]]',
+        ]
+        for case in test_cases:
+            data = case.encode()
+            # cut the input at every position: inside strings, escape sequences, UTF-8 sequences, numbers and literals
+            for n in (1, 2, 3, 7, 64):
+                with self.subTest(msg=f'decoding_incremental_test(case={case[:40]}, n={n})'):
+                    decoder = cjson.IncrementalDecoder()
+                    for i in range(0, len(data), n):
+                        decoder.feed(data[i:i + n])
+                    self._check_obj_same(decoder.close(), json.loads(case))
+        decoder = cjson.IncrementalDecoder(object_hook=lambda obj: obj.get("a", obj), max_depth=3)
+        decoder.feed('\ufeff[{"a": ')
+        decoder.feed("1}]")
+        self.assertEqual(decoder.close(), [1])
+        # the decoder starts over after close and after an error, with the positions of loads
+        for case in ["[1, 2", '["a", x]', "[1] 2", "[[[[1]]]]", "", '"\\x"', '["é", x]', '["€"] 2', '{"🚀": "\\x"}']:
+            with self.subTest(msg=f'decoding_incremental_fail_test(case={case})'):
+                with self.assertRaises(ValueError) as expected:
+                    cjson.loads(case, max_depth=3)
+                with self.assertRaises(ValueError) as raised:
+                    for c in case:
+                        decoder.feed(c)
+                    decoder.close()
+                self.assertEqual(str(raised.exception), str(expected.exception))
+        decoder.feed("[true]")
+        self.assertEqual(decoder.close(), [True])
+        with self.assertRaises(TypeError):
+            decoder.feed(1)
+        # str chunks of different widths are kept as characters, a document is fed either as str or as bytes
+        decoder = cjson.IncrementalDecoder()
+        for chunk in ['["a', 'é", "', '€", "🚀', '", "x"]']:
+            decoder.feed(chunk)
+        self.assertEqual(decoder.close(), ["aé", "€", "🚀", "x"])
+        decoder.feed("[1, ")
+        with self.assertRaises(TypeError):
+            decoder.feed(b"2]")
+        decoder.feed("2]")
+        self.assertEqual(decoder.close(), [1, 2])
+
+    def test_lines(self):
+        import io
+        import json
+
+        import cjson
+
+        lines = ['{"id": 1, "name": "a"}', "", '  [1, "é€🚀"] \r', "bad", '{"id": 2, "name": "b"}', '{"a": [}', "3"]
+        text = "\n".join(lines)
+        expected = [json.loads(line) if line.strip() else None for line in lines[:3]] + [None, json.loads(lines[4]), None, 3]
+        for source in (lambda: text, lambda: text.encode(), lambda: io.StringIO(text), lambda: io.BytesIO(text.encode())):
+            decode = cjson.loads_lines if isinstance(source(), (str, bytes)) else cjson.iter_lines
+            with self.subTest(msg=f'decoding_lines_test(source={type(source()).__name__})'):
+                with self.assertRaisesRegex(ValueError, "invalid value"):
+                    list(decode(source()))
+                self.assertEqual(list(decode(source(), errors="skip")), [v for v in expected if v is not None])
+                result = list(decode(source(), errors="collect"))
+                self.assertEqual([v for v in result if not isinstance(v, ValueError)], [v for v in expected if v is not None])
+                self.assertEqual([v.lineno for v in result if isinstance(v, ValueError)], [4, 6])
+        # the keys of all lines are created once
+        result = cjson.loads_lines(b'{"id": 1}\n{"id": 2}\n')
+        self.assertIs(next(iter(result[0])), next(iter(result[1])))
+        # lines longer than a read
+        text = (json.dumps({"k": "x" * 100000}) + "\n") * 3
+        self.assertEqual(list(cjson.iter_lines(io.StringIO(text))), [json.loads(line) for line in text.splitlines()])
+        self.assertEqual(cjson.loads_lines(""), [])
+        with self.assertRaises(ValueError):
+            cjson.loads_lines("1", errors="ignore")
+
+    def test_lines_parallel(self):
+        import tempfile
+
+        import cjson
+
+        lines = ['{"id": 1, "name": "é€🚀"}', "", '  [1, 2.5, 1e400, 123456789012345678901234567890] ', "bad", '{"a": [}', '"\\ud83d\\ude80"']
+        # more than one chunk, with a line across the boundary of the first; errors report byte positions, as for bytes
+        data = "\n".join(lines * 20000 + ['{"k": "' + "x" * (1 << 20) + '"}'] + lines * 20000).encode()
+        with tempfile.NamedTemporaryFile(delete=False) as file:
+            file.write(data)
+        try:
+            for threads in (1, 2, 4, 0):
+                with self.subTest(msg=f'decoding_lines_parallel_test(threads={threads})'):
+                    with self.assertRaisesRegex(ValueError, "invalid value"):
+                        cjson.load_lines_parallel(file.name, threads=threads)
+                    self.assertEqual(cjson.load_lines_parallel(file.name, threads=threads, errors="skip"), cjson.loads_lines(data, errors="skip"))
+                    result = cjson.load_lines_parallel(file.name, threads=threads, errors="collect")
+                    expected = cjson.loads_lines(data, errors="collect")
+                    self.assertEqual([(str(v), v.lineno) if isinstance(v, ValueError) else v for v in result],
+                                     [(str(v), v.lineno) if isinstance(v, ValueError) else v for v in expected])
+            self.assertEqual(cjson.load_lines_parallel(file.name, threads=2, errors="skip", object_hook=len)[:1], [2])
+            with self.assertRaises(ValueError):
+                cjson.load_lines_parallel(file.name, threads=-1)
+        finally:
+            os.unlink(file.name)
+        # procfs files report a size of 0 whatever they hold, so they are read instead of mapped
+        if os.path.exists("/proc/self/status"):
+            result = cjson.load_lines_parallel("/proc/self/status", threads=2, errors="collect")
+            self.assertTrue(result)
+            self.assertTrue(all(isinstance(value, ValueError) for value in result))
+
+    def test_parallel_document(self):
+        import cjson
+
+        # several chunks, with elements and strings across their boundaries
+        data = ("[" + ",".join(['{"id": %d, "s": "é\\"[,]{\\\\"}' % i for i in range(60000)] + ['"' + "x" * (1 << 20) + '"'] + ["[1, 2.5]"] * 60000) + "]").encode()
+        expected = cjson.loads(data)
+        for threads in (2, 4, 0):
+            with self.subTest(msg=f'decoding_parallel_document_test(threads={threads})'):
+                self.assertEqual(cjson.loads(data, threads=threads), expected)
+                calls = []
+                cjson.loads(data, threads=threads, object_hook=calls.append)
+                self.assertEqual(len(calls), 60000)
+                # errors are the ones of the parser, wherever the scanned elements stop
+                for invalid in (data[:-1], data + b" ", data[:-300000] + b"?" + data[-299999:], data.replace(b"[1, 2.5]", b"[1, 2.5", 1)):
+                    with self.assertRaises(ValueError) as serial:
+                        cjson.loads(invalid)
+                    with self.assertRaises(ValueError) as parallel:
+                        cjson.loads(invalid, threads=threads)
+                    self.assertEqual(str(parallel.exception), str(serial.exception))
+                # a mutable buffer changed by object_hook does not change what the workers scanned
+                source = bytearray(data)
+
+                def hook(obj):
+                    source[-(1 << 20):] = b"\\" * (1 << 20)
+                    return obj
+
+                self.assertEqual(cjson.loads(source, threads=threads, object_hook=hook), expected)
+        with self.assertRaises(ValueError):
+            cjson.loads(data, threads=-1)
+
+    def test_raw_decode(self):
+        import cjson
+
+        for source in ('{"a": [1, "é"]} 2\n"x"  null', '{"a": [1, "é"]} 2\n"x"  null'.encode()):
+            with self.subTest(msg=f'raw_decode_test(source={type(source).__name__})'):
+                values = []
+                index = 0
+                while index < len(source):
+                    value, index = cjson.raw_decode(source, index)
+                    values.append(value)
+                self.assertEqual(values, [{"a": [1, "é"]}, 2, "x", None])
+                self.assertEqual(index, len(source))
+        self.assertEqual(cjson.raw_decode(memoryview(b"xx[1]yy"), 2), ([1], 5))
+        # the index returned is past the whitespace after the document, so a stream ending in a newline ends cleanly
+        for source, expected in (('{"a": 1}\n{"b": 2}\n', [{"a": 1}, {"b": 2}]), (b'{"a": 1}\n{"b": 2}\n', [{"a": 1}, {"b": 2}]),
+                                 ('"é" \n 1 \r\n', ["é", 1])):
+            with self.subTest(msg=f'raw_decode_test(trailing={source!r})'):
+                values = []
+                index = 0
+                while index < len(source):
+                    value, index = cjson.raw_decode(source, index)
+                    values.append(value)
+                self.assertEqual(values, expected)
+                self.assertEqual(index, len(source))
+        self.assertEqual(cjson.raw_decode('{"a": 1}\n{"b": 2}\n', 9), ({"b": 2}, 18))
+        with self.assertRaisesRegex(ValueError, "position: 4"):
+            cjson.raw_decode(b"1 [2", 1)
+        for index in (-1, 2):
+            with self.assertRaises(ValueError):
+                cjson.raw_decode("1", index)
+
+    def test_lazy_loads(self):
+        import cjson
+
+        source = '{"a": [1, {"b": null}, "x\\ny"], "\\u00e9": 1.5, "c": {"d": [true]}, "c": {"d": []}}'
+        for value in (source, source.encode(), bytearray(source.encode())):
+            with self.subTest(msg=f'lazy_loads_test(source={type(value).__name__})'):
+                doc = cjson.lazy_loads(value)
+                self.assertIsInstance(doc, cjson.Node)
+                self.assertEqual(doc.materialize(), cjson.loads(value))
+                self.assertEqual(doc["a"][1].materialize(), {"b": None})
+                self.assertEqual(doc["a"][-1], "x\ny")
+                self.assertEqual(doc["é"], 1.5)
+                self.assertEqual(doc["c"]["d"].materialize(), [])
+                self.assertEqual(list(doc), ["a", "é", "c", "c"])
+                self.assertEqual(list(doc["a"])[0], 1)
+                self.assertEqual((len(doc), len(doc["a"])), (4, 3))
+                self.assertEqual((doc.get("z", 0), doc["a"].get(3)), (0, None))
+                self.assertTrue("c" in doc and 1 in doc["a"])
+                with self.assertRaises(KeyError):
+                    doc["z"]
+                with self.assertRaises(IndexError):
+                    doc["a"][3]
+                with self.assertRaises(TypeError):
+                    doc["a"]["b"]
+        self.assertEqual(cjson.lazy_loads(' "s"'), "s")
+        # small objects are searched and large ones indexed, keys are compared without caching their UTF-8 on them
+        for count in (3, 40):
+            members = {f"k{i}é€🚀"[: 2 + i % 4]: i for i in range(count)}
+            members.update({"x": 0, "\u00e9\n": 1, "🚀": 2})
+            doc = cjson.lazy_loads(cjson.dumps(members))
+            for key, value in members.items():
+                key = "".join(list(key))
+                size = sys.getsizeof(key)
+                with self.subTest(msg=f'lazy_loads_test(count={count}, key={key!r})'):
+                    self.assertEqual(doc[key], value)
+                    self.assertEqual(sys.getsizeof(key), size)
+            self.assertEqual(cjson.lazy_loads('{' + ', '.join(f'"k{i}": {i}' for i in range(count)) + ', "k0": -1}')["k0"], -1)
+            self.assertNotIn("k", doc)
+            self.assertEqual(doc.get(1, 0), 0)
+        # invalid numbers are rejected by the call, positions in str count characters
+        for value in ('[1,', '{"a": 1} x', '[[1]]', b'[1-2]', b'[1e]', '["é", 1-2]', '{"€": 1.5e}'):
+            with self.assertRaises(ValueError) as expected:
+                cjson.loads(value, max_depth=1)
+            with self.assertRaises(ValueError) as error:
+                cjson.lazy_loads(value, max_depth=1)
+            self.assertEqual(str(error.exception), str(expected.exception))
+
+    def test_compile_query(self):
+        import cjson
+
+        source = '{"user": {"id": 7, "tags": ["a", "b"]}, "a/b": [{"t": 1}, {"u": 2}, {"t": "\\u00e9"}], "user": {"id": 8}}'
+        query = cjson.compile_query(["/user/id", "$['a/b'][*].t", "/a~1b/1", "/user/tags", "$.missing[0]", ""])
+        self.assertEqual(query.paths[0], "/user/id")
+        for value in (source, source.encode()):
+            with self.subTest(msg=f'compile_query_test(source={type(value).__name__})'):
+                self.assertEqual(query.extract(value), [8, [1, "é"], {"u": 2}, None, None, cjson.loads(value)])
+        self.assertEqual(cjson.compile_query(["/1", "$[*]", "$.*"]).extract("[0, [1]]"), [[1], [0, [1]], [0, [1]]])
+        self.assertEqual(cjson.compile_query(["/a"]).extract('{"b": [1, {"x": "]"}], "a": 2}'), [2])
+        with self.assertRaisesRegex(ValueError, "expected colon"):
+            query.extract('{"user" 1}')
+        with self.assertRaisesRegex(ValueError, "position: 16"):
+            query.extract('{"user": {"id": tru}}')
+        # positions in a str count characters, however the values selected are created
+        for value in ('{"é": 1, "user": {"id": tru}}', '{"user": {"id": 7}, "€": [1,}', '{"user": {"id": "🚀"}} x'):
+            with self.assertRaises(ValueError) as expected:
+                cjson.loads(value)
+            with self.assertRaises(ValueError) as error:
+                query.extract(value)
+            self.assertEqual(str(error.exception), str(expected.exception))
+        # the containers around the value selected count against max_depth, as in loads
+        for path, value in (("/a", '{"a": [[1]]}'), ("/a/0", '{"a": [[1]]}'), ("/a/0/0", '{"a": [[[1]]]}')):
+            with self.assertRaises(ValueError) as expected:
+                cjson.loads(value, max_depth=2)
+            with self.assertRaises(ValueError) as error:
+                cjson.compile_query([path], max_depth=2).extract(value)
+            self.assertEqual(str(error.exception), str(expected.exception))
+        self.assertEqual(cjson.compile_query(["/a"], max_depth=2).extract('{"a": [1]}'), [[1]])
+        for path in ("user", "$.", "$[01]", "/~2", "$['a'"):
+            with self.assertRaises(ValueError):
+                cjson.compile_query([path])
+        with self.assertRaises(TypeError):
+            cjson.compile_query("/user")
+
+    def test_projection(self):
+        import cjson
+
+        source = '{"id": 1, "user": {"name": "\u20ac", "bio": [1, {"x": 2.5}]}, "rows": [{"id": 2, "v": 3}, 4], "id2": null}'
+        for value in (source, source.encode()):
+            with self.subTest(msg=f'projection_test(source={type(value).__name__})'):
+                self.assertEqual(cjson.loads(value, include={"id": True, "user": {"name": True}}), {"id": 1, "user": {"name": "€"}})
+                self.assertEqual(cjson.loads(value, include={"rows": {"id": True}, "id2": 1, "bio": True}), {"rows": [{"id": 2}, 4], "id2": None})
+                self.assertEqual(cjson.loads(value, exclude={"user": {"bio": True}, "rows": True, "id": False}), {"id": 1, "user": {"name": "€"}, "id2": None})
+                self.assertEqual(cjson.loads(value, include={}), {})
+        # the members left out are still checked
+        with self.assertRaisesRegex(ValueError, "invalid value\nposition: 13"):
+            cjson.loads('{"a": [1, 2, tru], "b": 1}', include={"b": True})
+        with self.assertRaisesRegex(ValueError, "too deeply nested"):
+            cjson.loads('{"a": [[[1]]], "b": 1}', include={"b": True}, max_depth=3)
+        with self.assertRaises(ValueError):
+            cjson.loads("{}", include={}, exclude={})
+        with self.assertRaises(TypeError):
+            cjson.loads("{}", include=["a"])
+
+    def test_validate(self):
+        import cjson
+
+        for value in ('{"a": [1, -2.5e3, "\\u00e9", null]}', '["€", 12345678901234567890123]', b"\xef\xbb\xbf[1]"):
+            with self.subTest(msg=f'validate_test(source={value!r})'):
+                self.assertIs(cjson.validate(value), True)
+        # a str is validated in its own 1, 2 or 4 byte representation, the escaped character is reported as loads does
+        for value in ('', '[1,', '{"a" 1}', '[1] ', '"\\x"', '[1e]', '[1-2]', '[[[]]]', b'"\xff"', '{\n "€": [1,\n  2 x]}',
+                      '["é", "\\é"]', '["€", 1e]', '\ufeff["🚀", "\\🚀"]'):
+            with self.subTest(msg=f'validate_test(source={value!r})'):
+                with self.assertRaises(ValueError) as expected:
+                    cjson.loads(value, max_depth=2)
+                error = cjson.validate(value, max_depth=2)
+                self.assertIsInstance(error, cjson.JSONDecodeError)
+                self.assertEqual(str(error), str(expected.exception))
+        if hasattr(sys, "get_int_max_str_digits"):
+            # an integer with more digits than int takes, in a member that a projection skips too
+            value = '{"a": [-%s], "b": 1}' % ("1" * (sys.get_int_max_str_digits() + 1))
+            with self.assertRaises(ValueError) as expected:
+                cjson.loads(value)
+            self.assertEqual(str(cjson.validate(value)), str(expected.exception))
+            with self.assertRaises(ValueError) as skipped:
+                cjson.loads(value, exclude={"a": True})
+            self.assertEqual(str(skipped.exception), str(expected.exception))
+        error = cjson.validate('{\n "€": [1,\n  2 x]}')
+        self.assertEqual((error.msg, error.pos, error.lineno, error.colno), ("Failed to parse array: expected end of array", 16, 3, 5))
+        with self.assertRaises(TypeError):
+            cjson.validate(1)
+
     def test_object_hook(self):
         import cjson
         import json
@@ -63,6 +63,52 @@ class TestJsonFileIO(unittest.TestCase):
                 json_data = json.load(f)
             self._check_obj_same(cjson_data, json_data)
 
+    def test_json_load_path_fd(self):
+        import cjson
+        import tempfile
+        import threading
+
+        for file, data in zip(self.file_path, self.datas):
+            self._check_obj_same(cjson.load_path(file), data)
+            fd = os.open(file, os.O_RDONLY)
+            try:
+                self._check_obj_same(cjson.load_fd(fd), data)
+            finally:
+                os.close(fd)
+
+        # pipes cannot be mapped and are read instead
+        data = self.datas[0]
+        read_fd, write_fd = os.pipe()
+
+        def write():
+            with open(write_fd, "wb") as f:
+                f.write(json.dumps(data).encode())
+
+        writer = threading.Thread(target=write)
+        writer.start()
+        try:
+            self._check_obj_same(cjson.load_fd(read_fd), data)
+        finally:
+            writer.join()
+            os.close(read_fd)
+
+        with self.assertRaises(FileNotFoundError):
+            cjson.load_path(self.file_path[0] + ".missing")
+
+        # procfs files report a size of 0 whatever they hold, so they are read instead of mapped
+        proc_file = "/proc/self/status"
+        if os.path.exists(proc_file):
+            with open(proc_file, "rb") as f:
+                content = f.read()
+            with self.assertRaises(ValueError) as expected:
+                cjson.loads(content)
+            with self.assertRaises(ValueError) as context:
+                cjson.load_path(proc_file)
+            self.assertEqual(str(context.exception), str(expected.exception))
+        with tempfile.NamedTemporaryFile() as f:
+            with self.assertRaisesRegex(ValueError, "Empty string"):
+                cjson.load_path(f.name)
+
     def test_json_dump(self):
         import cjson
         import tempfile